@@ -1,5 +1,5 @@
 #include <iostream>
-#include "RandomStreamGen.cpp"
+#include "RandomStreamGen.hpp"
 
 int main() {
     RandomStreamGen::Config cfg;
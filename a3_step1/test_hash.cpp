@@ -3,9 +3,13 @@
 #include <cmath>
 #include <algorithm>
 #include <unordered_set>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
 
-#include "RandomStreamGen.cpp"
-#include "HashFuncGen.cpp"
+#include "RandomStreamGen.hpp"
+#include "HashFuncGen.hpp"
 
 struct UniformityStats {
     double mean = 0.0;
@@ -45,12 +49,242 @@ UniformityStats testUniformity(const HashFunc& h,
     return {mean, var, mn, mx};
 }
 
-int main() {
+// ---- параллельная проверка семейства хешей: много seed-ов из makeMany за один прогон ----
+
+// Верхняя регуляризованная гамма-функция Q(a, x): ряд при x < a + 1, иначе цепная дробь.
+static double gammaQ(double a, double x) {
+    if (x <= 0.0) return 1.0;
+    const double lg = std::lgamma(a);
+    if (x < a + 1.0) {
+        double term = 1.0 / a, sum = term;
+        for (int n = 1; n < 100000; ++n) {
+            term *= x / (a + n);
+            sum += term;
+            if (term < sum * 1e-15) break;
+        }
+        return 1.0 - sum * std::exp(-x + a * std::log(x) - lg);
+    }
+    const double tiny = 1e-300;
+    double b = x + 1.0 - a, c = 1.0 / tiny, d = 1.0 / b, f = d;
+    for (int i = 1; i < 100000; ++i) {
+        double an = -i * (i - a);
+        b += 2.0;
+        d = an * d + b;
+        if (std::fabs(d) < tiny) d = tiny;
+        c = b + an / c;
+        if (std::fabs(c) < tiny) c = tiny;
+        d = 1.0 / d;
+        double delta = d * c;
+        f *= delta;
+        if (std::fabs(delta - 1.0) < 1e-15) break;
+    }
+    return std::exp(-x + a * std::log(x) - lg) * f;
+}
+
+// p-значение хи-квадрат с df степенями свободы.
+static double chiSquarePValue(double chi2, double df) {
+    return gammaQ(df / 2.0, chi2 / 2.0);
+}
+
+struct HarnessConfig {
+    std::size_t seeds = 256;
+    std::size_t threads = 0;       // 0 — по числу ядер
+    int binsPow2 = 12;             // бины по старшим битам для хи-квадрат
+    int B = 14;                    // разбиение хеша как в HyperLogLog: idx | w
+    std::size_t avalancheKeys = 2000;
+};
+
+// Локальные данные потока; сливаются в конце.
+struct HarnessAccum {
+    static constexpr int kInBits = 64; // первые 8 байт строки
+    std::vector<std::uint64_t> avalanche = std::vector<std::uint64_t>(kInBits * 32, 0);
+    std::uint64_t avalancheTrials = 0;
+    std::vector<std::uint64_t> rho;     // rho = 1..L+1, суммарно по seed-ам
+};
+
+struct SeedResult {
+    double uniformP = 0.0; // хи-квадрат по бинам старших бит
+    double rhoP = 0.0;     // хи-квадрат распределения rho против 2^-k
+    double regMaxDev = 0.0; // max |cnt - mean| / mean по регистрам idx
+};
+
+static void evaluateSeed(const HashFunc& h, const std::vector<std::string>& data,
+                         const std::vector<const std::string*>& avKeys,
+                         const HarnessConfig& cfg, HarnessAccum& acc, SeedResult& out,
+                         std::vector<std::uint32_t>& bins, std::vector<std::uint32_t>& regs,
+                         std::vector<std::uint64_t>& rho) {
+    const int L = 32 - cfg.B;
+    std::fill(bins.begin(), bins.end(), 0);
+    std::fill(regs.begin(), regs.end(), 0);
+    std::fill(rho.begin(), rho.end(), 0);
+
+    for (const auto& s : data) {
+        std::uint32_t x = h(s);
+        bins[x >> (32 - cfg.binsPow2)]++;
+        regs[x >> L]++;
+        std::uint32_t w = x << cfg.B;
+        rho[w == 0 ? L + 1 : std::min(__builtin_clz(w) + 1, L + 1)]++;
+    }
+
+    const double n = static_cast<double>(data.size());
+    double e = n / bins.size(), chi2 = 0.0;
+    for (std::uint32_t c : bins) chi2 += (c - e) * (c - e) / e;
+    out.uniformP = chiSquarePValue(chi2, static_cast<double>(bins.size() - 1));
+
+    double regMean = n / regs.size(), dev = 0.0;
+    for (std::uint32_t c : regs) dev = std::max(dev, std::fabs(c - regMean));
+    out.regMaxDev = dev / regMean;
+
+    // Хвост rho с ожиданием < 5 объединяется в одну ячейку.
+    double chi2r = 0.0, tailObs = 0.0, tailExp = 0.0;
+    int cells = 0;
+    for (int k = 1; k <= L + 1; ++k) {
+        double ek = n * (k <= L ? std::ldexp(1.0, -k) : std::ldexp(1.0, -L));
+        if (ek >= 5.0) {
+            chi2r += (rho[k] - ek) * (rho[k] - ek) / ek;
+            cells++;
+        } else {
+            tailObs += rho[k];
+            tailExp += ek;
+        }
+    }
+    if (tailExp > 0.0) {
+        chi2r += (tailObs - tailExp) * (tailObs - tailExp) / tailExp;
+        cells++;
+    }
+    out.rhoP = chiSquarePValue(chi2r, cells - 1);
+    for (int k = 1; k <= L + 1; ++k) acc.rho[k] += rho[k];
+
+    // Лавина: для каждого бита первых 8 байт — какие из 32 выходных бит поменялись.
+    for (const std::string* key : avKeys) {
+        std::string t = *key;
+        std::uint32_t base = h(t);
+        for (int bit = 0; bit < HarnessAccum::kInBits; ++bit) {
+            t[bit >> 3] ^= static_cast<char>(1 << (bit & 7));
+            std::uint32_t diff = base ^ h(t);
+            t[bit >> 3] ^= static_cast<char>(1 << (bit & 7));
+            std::uint64_t* row = &acc.avalanche[bit * 32];
+            for (int o = 0; o < 32; ++o) row[o] += (diff >> o) & 1u;
+        }
+    }
+    acc.avalancheTrials += avKeys.size();
+}
+
+static void runHarness(const std::vector<std::string>& data, const HarnessConfig& cfg) {
+    const int L = 32 - cfg.B;
+    std::size_t threads = cfg.threads ? cfg.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, cfg.seeds);
+
+    HashFuncGen hgen(777);
+    std::vector<HashFunc> funcs = hgen.makeMany(cfg.seeds);
+
+    std::vector<const std::string*> avKeys;
+    for (const auto& s : data) {
+        if (avKeys.size() == cfg.avalancheKeys) break;
+        if (s.size() >= 8) avKeys.push_back(&s);
+    }
+
+    std::vector<SeedResult> results(cfg.seeds);
+    std::vector<HarnessAccum> accs(threads);
+    std::atomic<std::size_t> next{0};
+
+    auto worker = [&](std::size_t t) {
+        HarnessAccum& acc = accs[t];
+        acc.rho.assign(L + 2, 0);
+        std::vector<std::uint32_t> bins(1u << cfg.binsPow2), regs(1u << cfg.B);
+        std::vector<std::uint64_t> rho(L + 2);
+        for (std::size_t i; (i = next.fetch_add(1)) < cfg.seeds;) {
+            evaluateSeed(funcs[i], data, avKeys, cfg, acc, results[i], bins, regs, rho);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+
+    HarnessAccum total;
+    total.rho.assign(L + 2, 0);
+    for (const auto& a : accs) {
+        for (std::size_t i = 0; i < total.avalanche.size(); ++i) total.avalanche[i] += a.avalanche[i];
+        for (int k = 0; k <= L + 1; ++k) total.rho[k] += a.rho[k];
+        total.avalancheTrials += a.avalancheTrials;
+    }
+
+    // При хорошем семействе p-значения по seed-ам равномерны на [0, 1].
+    auto summarizeP = [&](const std::string& name, double SeedResult::*field) {
+        std::vector<double> p;
+        for (const auto& r : results) p.push_back(r.*field);
+        std::sort(p.begin(), p.end());
+        double ks = 0.0;
+        for (std::size_t i = 0; i < p.size(); ++i) {
+            ks = std::max(ks, std::max((i + 1.0) / p.size() - p[i], p[i] - double(i) / p.size()));
+        }
+        std::size_t below1 = std::lower_bound(p.begin(), p.end(), 0.01) - p.begin();
+        std::size_t below5 = std::lower_bound(p.begin(), p.end(), 0.05) - p.begin();
+        std::cout << name << ": min p=" << p.front() << ", median p=" << p[p.size() / 2]
+                  << ", p<0.01: " << below1 << " (exp~" << p.size() * 0.01 << ")"
+                  << ", p<0.05: " << below5 << " (exp~" << p.size() * 0.05 << ")"
+                  << ", KS D=" << ks << " (crit 5%~" << 1.36 / std::sqrt(double(p.size())) << ")\n";
+    };
+
+    std::cout << "\n=== Hash family: " << cfg.seeds << " seeds, " << data.size()
+              << " unique keys, " << threads << " threads ===\n";
+    summarizeP("Top-bit chi2 (2^" + std::to_string(cfg.binsPow2) + " bins)", &SeedResult::uniformP);
+    summarizeP("rho chi2", &SeedResult::rhoP);
+
+    double worstReg = 0.0;
+    for (const auto& r : results) worstReg = std::max(worstReg, r.regMaxDev);
+    std::cout << "Registers (B=" << cfg.B << "): worst max|cnt-mean|/mean over seeds = " << worstReg << "\n";
+
+    std::cout << "rho distribution over all seeds (B=" << cfg.B << "):\n";
+    double n = static_cast<double>(data.size()) * cfg.seeds;
+    for (int k = 1; k <= std::min(8, L + 1); ++k) {
+        double exp = n * std::pow(0.5, k);
+        std::cout << "  rho=" << k << ": obs/exp~" << total.rho[k] / exp << "\n";
+    }
+
+    // Матрица смещения лавины: |P(выходной бит o меняется при флипе входного бита i) - 1/2|.
+    const double trials = static_cast<double>(total.avalancheTrials);
+    double maxBias = 0.0, sumBias = 0.0;
+    int worstIn = 0, worstOut = 0;
+    std::vector<double> rowBias(HarnessAccum::kInBits, 0.0);
+    for (int i = 0; i < HarnessAccum::kInBits; ++i) {
+        for (int o = 0; o < 32; ++o) {
+            double b = std::fabs(total.avalanche[i * 32 + o] / trials - 0.5);
+            sumBias += b;
+            rowBias[i] = std::max(rowBias[i], b);
+            if (b > maxBias) {
+                maxBias = b;
+                worstIn = i;
+                worstOut = o;
+            }
+        }
+    }
+    std::cout << "Avalanche (" << total.avalancheTrials << " key flips per bit): mean bias="
+              << sumBias / (HarnessAccum::kInBits * 32) << ", max bias=" << maxBias
+              << " (in bit " << worstIn << " -> out bit " << worstOut << "), noise~"
+              << 0.5 / std::sqrt(trials) << "\n";
+    std::cout << "Max bias per input byte:";
+    for (int byte = 0; byte < HarnessAccum::kInBits / 8; ++byte) {
+        double b = *std::max_element(rowBias.begin() + byte * 8, rowBias.begin() + byte * 8 + 8);
+        std::cout << " " << b;
+    }
+    std::cout << "\n";
+}
+
+// test_hash [seeds=256] [N=200000] [threads=0]
+int main(int argc, char** argv) {
+    HarnessConfig hc;
+    if (argc > 1) hc.seeds = std::strtoull(argv[1], nullptr, 10);
+    const std::size_t N = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+    if (argc > 3) hc.threads = std::strtoull(argv[3], nullptr, 10);
+    if (hc.seeds == 0) hc.seeds = 1;
+
     RandomStreamGen::Config cfg;
     cfg.seed = 42;
     RandomStreamGen gen(cfg);
 
-    auto stream = gen.generate(200000);
+    auto stream = gen.generate(N);
 
     HashFuncGen hgen(777);
     auto h = hgen.make();
@@ -64,4 +298,7 @@ int main() {
     std::cout << "Var per bin: " << st.variance << "\n";
     std::cout << "Min count:   " << st.minCount << "\n";
     std::cout << "Max count:   " << st.maxCount << "\n";
+
+    std::vector<std::string> data(uniq.begin(), uniq.end());
+    runHarness(data, hc);
 }
@@ -0,0 +1,389 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "HyperLogLog.hpp"
+
+// Временной ряд HyperLogLog: по скетчу на корзину времени (например, минуту) и запросы
+// «различных за произвольный интервал», которые сворачиваются в час/сутки/месяц.
+//
+// Хранение. Закрытая корзина кодируется разностью с предыдущей непустой корзиной
+// или относительно нулей — берётся самая короткая из кодировок:
+//   Sparse    — пары (varint пропуск, zigzag-разность) только для изменившихся регистров;
+//   SparseAbs — те же пары относительно нулей, т.е. только ненулевые регистры;
+//   Nibble    — zigzag-разности по 4 бита на регистр (m/2 байт), если все |d| <= 7;
+//   Raw       — m байт как есть.
+// Разность выигрывает, только когда в соседних корзинах те же элементы (ограниченная
+// аудитория, которая приходит каждую минуту: series_run 2 20000 12 5000 — почти все
+// корзины Sparse). Если в корзине в основном новые элементы, регистры соседних
+// корзин независимы: пока корзина заполнена слабо, почти всегда короче SparseAbs
+// (series_run по умолчанию), при плотной — Raw. stats() считает обе разреженные отдельно.
+// Хранятся только непустые корзины (с номером корзины), пропуск во времени любой длины
+// стоит O(1) времени и памяти. Каждые keyframeEvery непустых корзин база сбрасывается
+// в нули (опорный кадр), поэтому декодирование одной корзины стоит не больше
+// keyframeEvery шагов; подряд идущие корзины декодируются за шаг каждая.
+//
+// Запросы. Над корзинами — неявное дерево отрезков: узел (L, q) покрывает корзины
+// [q * 2^L, (q + 1) * 2^L). Интервал раскладывается на O(log n) канонических узлов;
+// узлы без непустых корзин пропускаются двоичным поиском. Объединение (max по
+// регистрам) узла считается при первом обращении и, начиная
+// с уровня minCachedLevel, кэшируется (LRU в пределах cacheBytes). Кэшируются только узлы из закрытых корзин —
+// они не меняются, поэтому кэш не инвалидируется. Текущая открытая корзина
+// добавляется к ответу напрямую.
+//
+// Время — целые секунды (или любые единицы); корзины выровнены на кратные bucketWidth.
+// Элементы, опоздавшие в уже закрытую корзину, отбрасываются и считаются в stats().late.
+// Номер корзины от первой ограничен kMaxBuckets (2^48): время дальше — ошибка единиц
+// (например, миллисекунды вместо секунд), add() и advanceTo() бросают invalid_argument.
+class CardinalitySeries {
+public:
+    static constexpr std::int64_t kMaxBuckets = std::int64_t(1) << 48;
+
+    struct Options {
+        int B = 12;
+        std::int64_t bucketWidth = 60;
+        std::size_t keyframeEvery = 64;
+        std::size_t cacheBytes = std::size_t(64) << 20;
+        int minCachedLevel = 4; // нижние уровни дешевле собрать заново, чем держать в кэше
+    };
+
+    struct Stats {
+        std::uint64_t buckets = 0;      // закрытые, включая пустые
+        std::uint64_t emptyBuckets = 0; // не хранятся
+        std::size_t rawBuckets = 0;
+        std::size_t nibbleBuckets = 0;
+        std::size_t sparseBuckets = 0;    // разреженная разность с предыдущей корзиной
+        std::size_t sparseAbsBuckets = 0; // разреженно относительно нулей
+        std::size_t encodedBytes = 0;
+        std::size_t cachedNodes = 0;
+        std::size_t cacheBytes = 0;
+        std::uint64_t cacheHits = 0;
+        std::uint64_t cacheMisses = 0;
+        std::uint64_t decodes = 0;      // шагов декодирования корзин
+        std::uint64_t late = 0;
+    };
+
+    explicit CardinalitySeries(Options opt)
+        : opt_(opt), m_(std::uint32_t(1) << opt.B), open_(opt.B), encBase_(m_, 0) {
+        if (opt_.B < 4 || opt_.B > 20) throw std::invalid_argument("CardinalitySeries: B must be in [4, 20]");
+        if (opt_.bucketWidth <= 0) throw std::invalid_argument("CardinalitySeries: bucketWidth must be positive");
+        if (opt_.keyframeEvery == 0) throw std::invalid_argument("CardinalitySeries: keyframeEvery must be positive");
+    }
+
+    void add(std::int64_t t, std::uint32_t hash) {
+        std::int64_t b = floorDiv(t, opt_.bucketWidth);
+        if (!started_) {
+            origin_ = b;
+            started_ = true;
+        }
+        std::int64_t idx = b - origin_;
+        if (idx < sealed_) {
+            stats_.late++;
+            return;
+        }
+        sealTo(idx);
+        open_.addHash(hash);
+        openDirty_ = true;
+    }
+
+    // Закрывает все корзины до момента t (не включая корзину, в которую попадает t).
+    void advanceTo(std::int64_t t) {
+        if (!started_) return;
+        std::int64_t idx = floorDiv(t, opt_.bucketWidth) - origin_;
+        if (idx > sealed_) sealTo(idx);
+    }
+
+    // Объединение корзин, пересекающихся с [from, to).
+    HyperLogLog range(std::int64_t from, std::int64_t to) {
+        HyperLogLog out(opt_.B);
+        if (!started_ || to <= from) return out;
+        std::int64_t lo = std::max<std::int64_t>(floorDiv(from, opt_.bucketWidth) - origin_, 0);
+        std::int64_t hi = floorDiv(to - 1, opt_.bucketWidth) - origin_ + 1;
+        const std::int64_t sealed = sealed_;
+
+        std::vector<std::uint8_t> acc(m_, 0);
+        lastQueryNodes_ = 0;
+        for (std::int64_t l = lo, r = std::min(hi, sealed); l < r;) {
+            int L = 0;
+            while (L < 62 && (l & ((std::int64_t(1) << (L + 1)) - 1)) == 0 && l + (std::int64_t(2) << L) <= r) L++;
+            mergeNode(L, static_cast<std::uint64_t>(l >> L), acc.data());
+            lastQueryNodes_++;
+            l += std::int64_t(1) << L;
+        }
+        if (openDirty_ && lo <= sealed && sealed < hi) {
+            maxInto(acc.data(), open_.registers());
+            lastQueryNodes_++;
+        }
+        out.loadRegisters(acc.data());
+        return out;
+    }
+
+    double estimate(std::int64_t from, std::int64_t to) { return range(from, to).estimate(); }
+
+    // Оценки по корзинам ширины width (кратной bucketWidth), начиная с from.
+    std::vector<double> rollup(std::int64_t from, std::int64_t to, std::int64_t width) {
+        if (width <= 0 || width % opt_.bucketWidth != 0) {
+            throw std::invalid_argument("CardinalitySeries: rollup width must be a multiple of bucketWidth");
+        }
+        std::vector<double> out;
+        for (std::int64_t t = from; t < to; t += width) out.push_back(estimate(t, std::min(t + width, to)));
+        return out;
+    }
+
+    // Объединение корзин подряд, без дерева и кэша — для проверки и сравнения.
+    HyperLogLog rangeNaive(std::int64_t from, std::int64_t to) {
+        HyperLogLog out(opt_.B);
+        if (!started_ || to <= from) return out;
+        std::int64_t lo = std::max<std::int64_t>(floorDiv(from, opt_.bucketWidth) - origin_, 0);
+        std::int64_t hi = floorDiv(to - 1, opt_.bucketWidth) - origin_ + 1;
+        const std::int64_t sealed = sealed_;
+        std::vector<std::uint8_t> acc(m_, 0);
+        for (std::size_t k = firstAtOrAfter(lo); k < refs_.size() && refs_[k].idx < std::min(hi, sealed); ++k) {
+            maxInto(acc.data(), decode(k));
+        }
+        if (openDirty_ && lo <= sealed && sealed < hi) maxInto(acc.data(), open_.registers());
+        out.loadRegisters(acc.data());
+        return out;
+    }
+
+    int B() const { return opt_.B; }
+    std::int64_t bucketWidth() const { return opt_.bucketWidth; }
+    std::int64_t firstBucketStart() const { return origin_ * opt_.bucketWidth; }
+    std::size_t lastQueryNodes() const { return lastQueryNodes_; }
+
+    Stats stats() const {
+        Stats s = stats_;
+        s.buckets = static_cast<std::uint64_t>(sealed_);
+        s.emptyBuckets = s.buckets - refs_.size();
+        s.encodedBytes = data_.size();
+        s.cachedNodes = cache_.size();
+        s.cacheBytes = cache_.size() * m_;
+        return s;
+    }
+
+private:
+    enum class Kind : std::uint8_t { Raw, Nibble, Sparse, SparseAbs };
+
+    struct BucketRef {
+        std::int64_t idx; // номер корзины от origin_
+        std::uint64_t offset;
+        std::uint32_t size;
+        Kind kind;
+    };
+
+    struct CacheEntry {
+        std::vector<std::uint8_t> regs;
+        std::list<std::uint64_t>::iterator lru;
+    };
+
+    Options opt_;
+    std::uint32_t m_;
+    bool started_ = false;
+    std::int64_t origin_ = 0;
+
+    HyperLogLog open_;
+    bool openDirty_ = false;
+    std::vector<std::uint8_t> encBase_; // база разности для следующей непустой корзины
+    std::int64_t sealed_ = 0;           // корзины [0, sealed_) закрыты, sealed_ — открытая
+    std::vector<BucketRef> refs_;       // только непустые, по возрастанию idx
+    std::vector<std::uint8_t> data_;
+
+    // курсор последовательного декодирования (порядковый номер в refs_)
+    std::size_t curIdx_ = SIZE_MAX;
+    std::vector<std::uint8_t> curBase_;
+    std::vector<std::uint8_t> cur_;
+    std::vector<std::uint8_t> zeros_;
+
+    std::unordered_map<std::uint64_t, CacheEntry> cache_;
+    std::list<std::uint64_t> lru_; // front — самый свежий
+    std::size_t lastQueryNodes_ = 0;
+    Stats stats_;
+
+    static std::int64_t floorDiv(std::int64_t a, std::int64_t b) {
+        std::int64_t q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+
+    static std::uint8_t zigzag(int d) { return static_cast<std::uint8_t>(d >= 0 ? 2 * d : -2 * d - 1); }
+    static int unzigzag(std::uint8_t z) { return (z & 1) ? -static_cast<int>((z + 1) >> 1) : (z >> 1); }
+
+    void maxInto(std::uint8_t* dst, const std::uint8_t* src) const {
+        for (std::uint32_t i = 0; i < m_; ++i) dst[i] = std::max(dst[i], src[i]);
+    }
+
+    // Закрывает открытую корзину и все до idx; открытой становится корзина idx.
+    void sealTo(std::int64_t idx) {
+        if (idx >= kMaxBuckets) {
+            throw std::invalid_argument("CardinalitySeries: timestamp too far from the first bucket");
+        }
+        if (idx == sealed_) return;
+        if (openDirty_) {
+            const std::size_t k = refs_.size();
+            if (k % opt_.keyframeEvery == 0) std::fill(encBase_.begin(), encBase_.end(), 0);
+            const std::uint8_t* cur = open_.registers();
+            BucketRef ref{sealed_, data_.size(), 0, Kind::Raw};
+            ref.kind = encode(cur);
+            ref.size = static_cast<std::uint32_t>(data_.size() - ref.offset);
+            encBase_.assign(cur, cur + m_);
+            switch (ref.kind) {
+                case Kind::Raw: stats_.rawBuckets++; break;
+                case Kind::Nibble: stats_.nibbleBuckets++; break;
+                case Kind::Sparse: stats_.sparseBuckets++; break;
+                case Kind::SparseAbs: stats_.sparseAbsBuckets++; break;
+            }
+            refs_.push_back(ref);
+            open_.reset();
+            openDirty_ = false;
+        }
+        sealed_ = idx;
+    }
+
+    // Порядковый номер первой непустой корзины с номером >= idx.
+    std::size_t firstAtOrAfter(std::int64_t idx) const {
+        return static_cast<std::size_t>(
+            std::lower_bound(refs_.begin(), refs_.end(), idx,
+                             [](const BucketRef& r, std::int64_t v) { return r.idx < v; }) -
+            refs_.begin());
+    }
+
+    // Дописывает в data_ кодировку cur относительно encBase_ (или нулей, если так короче).
+    Kind encode(const std::uint8_t* cur) {
+        const std::uint8_t* base = encBase_.data();
+        std::size_t changed = 0;
+        std::size_t nonZero = 0;
+        bool fitsNibble = true;
+        for (std::uint32_t i = 0; i < m_; ++i) {
+            nonZero += cur[i] != 0;
+            if (cur[i] == base[i]) continue;
+            changed++;
+            fitsNibble = fitsNibble && zigzag(cur[i] - base[i]) < 16;
+        }
+        // Sparse занимает не меньше 2 байт на изменённый регистр — пробуем, только если может выиграть
+        const std::size_t dense = fitsNibble ? m_ / 2 : m_;
+        const bool absolute = nonZero < changed;
+        if (std::min(changed, nonZero) * 2 < dense) {
+            std::size_t start = data_.size();
+            appendSparse(cur, absolute ? zeros().data() : base);
+            if (data_.size() - start < dense) return absolute ? Kind::SparseAbs : Kind::Sparse;
+            data_.resize(start);
+        }
+        if (fitsNibble) {
+            for (std::uint32_t i = 0; i < m_; i += 2) {
+                data_.push_back(static_cast<std::uint8_t>(zigzag(cur[i] - base[i]) |
+                                                          (zigzag(cur[i + 1] - base[i + 1]) << 4)));
+            }
+            return Kind::Nibble;
+        }
+        data_.insert(data_.end(), cur, cur + m_);
+        return Kind::Raw;
+    }
+
+    void appendSparse(const std::uint8_t* cur, const std::uint8_t* base) {
+        std::uint32_t prev = 0;
+        for (std::uint32_t i = 0; i < m_; ++i) {
+            if (cur[i] == base[i]) continue;
+            for (std::uint32_t gap = i - prev;; gap >>= 7) {
+                if (gap < 0x80) {
+                    data_.push_back(static_cast<std::uint8_t>(gap));
+                    break;
+                }
+                data_.push_back(static_cast<std::uint8_t>(gap | 0x80));
+            }
+            data_.push_back(zigzag(cur[i] - base[i]));
+            prev = i;
+        }
+    }
+
+    const std::vector<std::uint8_t>& zeros() {
+        if (zeros_.size() != m_) zeros_.assign(m_, 0);
+        return zeros_;
+    }
+
+    // Регистры непустой корзины refs_[idx]. Указатель живёт до следующего decode().
+    const std::uint8_t* decode(std::size_t idx) {
+        std::size_t from = idx - idx % opt_.keyframeEvery;
+        if (curIdx_ == SIZE_MAX || curIdx_ > idx || curIdx_ < from) {
+            curBase_.assign(m_, 0);
+            cur_.assign(m_, 0);
+            curIdx_ = from;
+            step(from);
+        }
+        while (curIdx_ < idx) step(++curIdx_);
+        return cur_.data();
+    }
+
+    void step(std::size_t j) {
+        stats_.decodes++;
+        if (j % opt_.keyframeEvery == 0) std::fill(curBase_.begin(), curBase_.end(), 0);
+        const BucketRef& ref = refs_[j];
+        const std::uint8_t* p = data_.data() + ref.offset;
+        switch (ref.kind) {
+            case Kind::Raw:
+                std::copy(p, p + m_, cur_.begin());
+                break;
+            case Kind::Nibble:
+                for (std::uint32_t i = 0; i < m_; i += 2) {
+                    cur_[i] = static_cast<std::uint8_t>(curBase_[i] + unzigzag(p[i / 2] & 0x0F));
+                    cur_[i + 1] = static_cast<std::uint8_t>(curBase_[i + 1] + unzigzag(p[i / 2] >> 4));
+                }
+                break;
+            case Kind::Sparse:
+            case Kind::SparseAbs: {
+                const std::vector<std::uint8_t>& base = ref.kind == Kind::Sparse ? curBase_ : zeros();
+                cur_ = base;
+                const std::uint8_t* end = p + ref.size;
+                std::uint32_t i = 0;
+                while (p < end) {
+                    std::uint32_t gap = 0;
+                    for (int shift = 0;; shift += 7) {
+                        std::uint8_t c = *p++;
+                        gap |= static_cast<std::uint32_t>(c & 0x7F) << shift;
+                        if (!(c & 0x80)) break;
+                    }
+                    i += gap;
+                    cur_[i] = static_cast<std::uint8_t>(base[i] + unzigzag(*p++));
+                }
+                break;
+            }
+        }
+        curBase_ = cur_;
+    }
+
+    // acc |= объединение корзин узла (L, q).
+    void mergeNode(int L, std::uint64_t q, std::uint8_t* acc) {
+        const std::int64_t a = static_cast<std::int64_t>(q << L);
+        const std::int64_t b = a + (std::int64_t(1) << L);
+        std::size_t k = firstAtOrAfter(a);
+        if (k == refs_.size() || refs_[k].idx >= b) return; // узел целиком пустой
+        const bool single = k + 1 == refs_.size() || refs_[k + 1].idx >= b;
+        if (L < opt_.minCachedLevel || single) {
+            for (; k < refs_.size() && refs_[k].idx < b; ++k) maxInto(acc, decode(k));
+            return;
+        }
+        const std::uint64_t key = (static_cast<std::uint64_t>(L) << 56) | q;
+        auto it = cache_.find(key);
+        if (it != cache_.end()) {
+            stats_.cacheHits++;
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            maxInto(acc, it->second.regs.data());
+            return;
+        }
+        stats_.cacheMisses++;
+        std::vector<std::uint8_t> regs(m_, 0);
+        mergeNode(L - 1, 2 * q, regs.data());
+        mergeNode(L - 1, 2 * q + 1, regs.data());
+        maxInto(acc, regs.data());
+
+        if (opt_.cacheBytes < m_) return;
+        while ((cache_.size() + 1) * m_ > opt_.cacheBytes) {
+            cache_.erase(lru_.back());
+            lru_.pop_back();
+        }
+        lru_.push_front(key);
+        cache_.emplace(key, CacheEntry{std::move(regs), lru_.begin()});
+    }
+};
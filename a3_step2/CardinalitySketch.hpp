@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Общий интерфейс оценщиков числа уникальных элементов.
+// Все реализации принимают уже посчитанный 32-битный хеш (HashFunc),
+// поэтому один и тот же поток можно прогнать через разные скетчи.
+class CardinalitySketch {
+public:
+    virtual ~CardinalitySketch() = default;
+
+    virtual void reset() = 0;
+    virtual void addHash(std::uint32_t x) = 0;
+    virtual double estimate() const = 0;
+
+    virtual std::size_t memoryBytes() const = 0;
+    virtual std::string name() const = 0;
+};
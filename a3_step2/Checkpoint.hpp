@@ -0,0 +1,382 @@
+#pragma once
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "HashFuncGen.hpp"
+#include "Experiment.hpp"
+
+// Контрольные точки для долгих прогонов processOneStream.
+//
+// Файл (little-endian): "SET5CKP2" | u8 B | u64 seed хеша | u64 N | u64 отпечаток шагов
+//   | u64 отпечаток потока | u64 offset (обработано элементов) | u64 stepIdx
+//   | u64 число результатов, по 7 полей StepResult | m байт регистров
+//   | u64 FNV-1a всего предыдущего (оборванная запись не примется за целую).
+// Пишется во временный файл, fsync, rename — на диске всегда целая предыдущая или новая точка.
+
+// Чем определяется прогон. Точка, снятая с другим B, хешем, потоком или расписанием
+// шагов, не принимается — иначе в результат смешались бы шаги двух разных прогонов.
+struct CheckpointIdentity {
+    int B = 0;
+    std::uint64_t hashSeed = 0;
+    std::uint64_t streamSize = 0;
+    std::uint64_t stepsFingerprint = 0;  // FNV-1a по размерам шагов (доля шага и N)
+    std::uint64_t streamFingerprint = 0; // FNV-1a по всем элементам потока
+};
+
+struct Checkpoint {
+    CheckpointIdentity id;
+    std::uint64_t offset = 0;
+    std::uint64_t stepIdx = 0;
+    std::vector<StepResult> results;
+    std::vector<std::uint8_t> registers;
+};
+
+namespace ckpt_detail {
+
+constexpr std::uint64_t kFnvBasis = 14695981039346656037ULL;
+
+inline std::uint64_t fnv1a(const char* p, std::size_t n, std::uint64_t h = kFnvBasis) {
+    for (std::size_t i = 0; i < n; ++i) {
+        h ^= static_cast<unsigned char>(p[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+template <class T>
+inline void put(std::string& buf, T v) {
+    buf.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+template <class T>
+inline T get(const std::string& buf, std::size_t& off) {
+    if (buf.size() - off < sizeof(T)) throw std::runtime_error("checkpoint: truncated");
+    T v;
+    std::memcpy(&v, buf.data() + off, sizeof(T));
+    off += sizeof(T);
+    return v;
+}
+
+} // namespace ckpt_detail
+
+inline std::uint64_t stepsFingerprint(const std::vector<std::size_t>& steps) {
+    std::uint64_t h = ckpt_detail::kFnvBasis;
+    for (std::size_t x : steps) {
+        std::uint64_t v = x;
+        h = ckpt_detail::fnv1a(reinterpret_cast<const char*>(&v), sizeof(v), h);
+    }
+    return h;
+}
+
+// Длина перед каждым элементом — чтобы {"ab","c"} и {"a","bc"} различались.
+inline std::uint64_t streamFingerprint(const std::vector<std::string>& stream) {
+    std::uint64_t h = ckpt_detail::kFnvBasis;
+    for (const auto& s : stream) {
+        std::uint64_t n = s.size();
+        h = ckpt_detail::fnv1a(reinterpret_cast<const char*>(&n), sizeof(n), h);
+        h = ckpt_detail::fnv1a(s.data(), s.size(), h);
+    }
+    return h;
+}
+
+inline CheckpointIdentity makeCheckpointIdentity(int B, const HashFunc& h, const std::vector<std::string>& stream,
+                                                 const std::vector<std::size_t>& steps) {
+    CheckpointIdentity id;
+    id.B = B;
+    id.hashSeed = h.seed();
+    id.streamSize = stream.size();
+    id.stepsFingerprint = stepsFingerprint(steps);
+    id.streamFingerprint = streamFingerprint(stream);
+    return id;
+}
+
+// Пустая строка, если точка подходит к прогону, иначе — чем отличается.
+inline std::string checkpointMismatch(const CheckpointIdentity& saved, const CheckpointIdentity& run) {
+    if (saved.B != run.B) return "B " + std::to_string(saved.B) + " vs " + std::to_string(run.B);
+    if (saved.hashSeed != run.hashSeed) return "hash seed";
+    if (saved.streamSize != run.streamSize) {
+        return "N " + std::to_string(saved.streamSize) + " vs " + std::to_string(run.streamSize);
+    }
+    if (saved.stepsFingerprint != run.stepsFingerprint) return "step schedule";
+    if (saved.streamFingerprint != run.streamFingerprint) return "stream contents";
+    return "";
+}
+
+inline std::string encodeCheckpoint(const Checkpoint& c) {
+    using ckpt_detail::put;
+    std::string buf("SET5CKP2", 8);
+    put<std::uint8_t>(buf, static_cast<std::uint8_t>(c.id.B));
+    put(buf, c.id.hashSeed);
+    put(buf, c.id.streamSize);
+    put(buf, c.id.stepsFingerprint);
+    put(buf, c.id.streamFingerprint);
+    put(buf, c.offset);
+    put(buf, c.stepIdx);
+    put<std::uint64_t>(buf, c.results.size());
+    for (const auto& r : c.results) {
+        put<std::uint64_t>(buf, r.processed);
+        put<std::uint64_t>(buf, r.F0);
+        put(buf, r.Nt);
+        put(buf, r.stdErr);
+        put(buf, r.groupStdErr);
+        put(buf, r.lower);
+        put(buf, r.upper);
+    }
+    buf.append(reinterpret_cast<const char*>(c.registers.data()), c.registers.size());
+    put(buf, ckpt_detail::fnv1a(buf.data(), buf.size()));
+    return buf;
+}
+
+inline Checkpoint decodeCheckpoint(const std::string& buf) {
+    using ckpt_detail::get;
+    if (buf.size() < 16 || std::memcmp(buf.data(), "SET5CKP2", 8) != 0) {
+        throw std::runtime_error("checkpoint: not a checkpoint file");
+    }
+    std::uint64_t stored;
+    std::memcpy(&stored, buf.data() + buf.size() - 8, 8);
+    if (stored != ckpt_detail::fnv1a(buf.data(), buf.size() - 8)) throw std::runtime_error("checkpoint: checksum mismatch");
+
+    std::size_t off = 8;
+    Checkpoint c;
+    c.id.B = get<std::uint8_t>(buf, off);
+    if (c.id.B < 1 || c.id.B > 30) throw std::runtime_error("checkpoint: bad precision");
+    c.id.hashSeed = get<std::uint64_t>(buf, off);
+    c.id.streamSize = get<std::uint64_t>(buf, off);
+    c.id.stepsFingerprint = get<std::uint64_t>(buf, off);
+    c.id.streamFingerprint = get<std::uint64_t>(buf, off);
+    c.offset = get<std::uint64_t>(buf, off);
+    c.stepIdx = get<std::uint64_t>(buf, off);
+    std::uint64_t n = get<std::uint64_t>(buf, off);
+    if (n > buf.size() / 56) throw std::runtime_error("checkpoint: bad result count");
+    c.results.resize(n);
+    for (auto& r : c.results) {
+        r.processed = get<std::uint64_t>(buf, off);
+        r.F0 = get<std::uint64_t>(buf, off);
+        r.Nt = get<double>(buf, off);
+        r.stdErr = get<double>(buf, off);
+        r.groupStdErr = get<double>(buf, off);
+        r.lower = get<double>(buf, off);
+        r.upper = get<double>(buf, off);
+    }
+    std::size_t m = std::size_t(1) << c.id.B;
+    if (buf.size() - 8 - off != m) throw std::runtime_error("checkpoint: register array size mismatch");
+    c.registers.assign(buf.begin() + off, buf.begin() + off + m);
+    return c;
+}
+
+// Атомарная замена: tmp + fsync + rename.
+inline void writeCheckpointFile(const std::string& path, const std::string& data) {
+    const std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("Cannot open file for writing: " + tmp);
+    std::size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = ::write(fd, data.data() + off, data.size() - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ::close(fd);
+            throw std::runtime_error("checkpoint: write failed: " + tmp);
+        }
+        off += static_cast<std::size_t>(n);
+    }
+    bool ok = ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("checkpoint: cannot commit " + path);
+    }
+}
+
+// Пустой unique_ptr, если файла нет; битый файл — исключение.
+inline std::unique_ptr<Checkpoint> loadCheckpoint(const std::string& path) {
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> f(std::fopen(path.c_str(), "rb"), &std::fclose);
+    if (!f) return nullptr;
+    std::string buf;
+    char chunk[1 << 16];
+    for (std::size_t n; (n = std::fread(chunk, 1, sizeof(chunk), f.get())) > 0;) buf.append(chunk, n);
+    if (std::ferror(f.get())) throw std::runtime_error("Cannot read: " + path);
+    return std::unique_ptr<Checkpoint>(new Checkpoint(decodeCheckpoint(buf)));
+}
+
+// Фоновая запись контрольных точек с двойным буфером. submit() в потоке обработки
+// только копирует m байт регистров и результаты в свой буфер и обменивается им
+// с ожидающим; кодирование, запись и fsync идут в отдельном потоке. Если тот ещё пишет
+// прошлую точку, новая замещает ожидающую — на диск попадает самая свежая,
+// а обработка не ждёт диск.
+class AsyncCheckpointer {
+public:
+    AsyncCheckpointer(std::string path, const CheckpointIdentity& id)
+        : path_(std::move(path)), worker_([this] { loop(); }) {
+        back_.id = front_.id = inFlight_.id = id;
+    }
+
+    ~AsyncCheckpointer() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        worker_.join();
+    }
+
+    AsyncCheckpointer(const AsyncCheckpointer&) = delete;
+    AsyncCheckpointer& operator=(const AsyncCheckpointer&) = delete;
+
+    // regs — 2^B байт регистров.
+    void submit(const std::uint8_t* regs, std::uint64_t offset, std::uint64_t stepIdx,
+                const std::vector<StepResult>& results) {
+        Checkpoint& c = back_;
+        c.offset = offset;
+        c.stepIdx = stepIdx;
+        c.results = results;
+        c.registers.assign(regs, regs + (std::size_t(1) << c.id.B));
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            if (pending_) replaced_++;
+            std::swap(back_, front_);
+            pending_ = true;
+        }
+        cv_.notify_one();
+        submitted_++;
+    }
+
+    // Дожидается записи последней отправленной точки.
+    void flush() {
+        std::unique_lock<std::mutex> lk(mu_);
+        done_.wait(lk, [&] { return !pending_ && !writing_; });
+        if (!error_.empty()) throw std::runtime_error(error_);
+    }
+
+    // Счётчики читать после flush().
+    std::size_t submitted() const { return submitted_; }
+    std::size_t written() const { return written_; }
+    std::size_t replaced() const { return replaced_; }
+
+private:
+    std::string path_;
+    Checkpoint back_;  // заполняется потоком обработки
+    Checkpoint front_; // ждёт записи (под mu_)
+    Checkpoint inFlight_; // принадлежит потоку записи
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::condition_variable done_;
+    bool pending_ = false;
+    bool writing_ = false;
+    bool stop_ = false;
+    std::string error_;
+    std::size_t submitted_ = 0;
+    std::size_t written_ = 0;
+    std::size_t replaced_ = 0;
+    std::thread worker_;
+
+    void loop() {
+        std::unique_lock<std::mutex> lk(mu_);
+        for (;;) {
+            cv_.wait(lk, [&] { return pending_ || stop_; });
+            if (!pending_) return;
+            std::swap(front_, inFlight_);
+            pending_ = false;
+            writing_ = true;
+            lk.unlock();
+
+            try {
+                writeCheckpointFile(path_, encodeCheckpoint(inFlight_));
+                lk.lock();
+                written_++;
+            } catch (const std::exception& e) {
+                lk.lock();
+                error_ = e.what();
+            }
+            writing_ = false;
+            done_.notify_all();
+        }
+    }
+};
+
+struct CheckpointOptions {
+    std::string path;
+    std::size_t every = 1000000; // элементов между точками
+};
+
+struct NoProgressHook {
+    void operator()(std::size_t) const {}
+};
+
+// Хуки processOneStream (см. Experiment.hpp) с контрольными точками. Если по options.path
+// лежит точка того же прогона (CheckpointIdentity), регистры и готовые результаты
+// берутся из неё, а обработка продолжается со следующего элемента; точка другого
+// прогона — исключение. Результат совпадает с непрерывным прогоном.
+// Sketch — скетч с регистрами-байтами: B(), registers(), loadRegisters() (HyperLogLog).
+// onElement(processed) вызывается после каждого элемента (для тестов «падения»).
+template <class OnElement = NoProgressHook>
+class CheckpointHooks {
+public:
+    CheckpointHooks(const CheckpointOptions& options, OnElement onElement)
+        : options_(options), onElement_(std::move(onElement)) {}
+
+    template <class Sketch>
+    std::size_t resume(const std::vector<std::string>& stream, const HashFunc& h,
+                       const std::vector<std::size_t>& steps, Sketch& sketch,
+                       std::vector<StepResult>& out, std::size_t& stepIdx) {
+        const CheckpointIdentity id = makeCheckpointIdentity(sketch.B(), h, stream, steps);
+        every_ = options_.every ? options_.every : stream.size() + 1;
+        std::size_t start = 0;
+        if (auto c = loadCheckpoint(options_.path)) {
+            std::string diff = checkpointMismatch(c->id, id);
+            if (!diff.empty()) {
+                throw std::runtime_error("checkpoint " + options_.path + " belongs to another run (" + diff + ")");
+            }
+            if (c->offset > stream.size() || c->stepIdx > steps.size()) {
+                throw std::runtime_error("checkpoint " + options_.path + " is ahead of the stream");
+            }
+            sketch.loadRegisters(c->registers.data());
+            out = c->results;
+            start = c->offset;
+            stepIdx = c->stepIdx;
+        }
+        writer_.reset(new AsyncCheckpointer(options_.path, id));
+        return start;
+    }
+
+    template <class Sketch>
+    void afterElement(std::size_t processed, const Sketch& sketch, std::size_t stepIdx,
+                      const std::vector<StepResult>& out) {
+        if (processed % every_ == 0) writer_->submit(sketch.registers(), processed, stepIdx, out);
+        onElement_(processed);
+    }
+
+    void finish() {
+        if (writer_) writer_->flush();
+        std::remove(options_.path.c_str()); // прогон завершён — точка больше не нужна
+    }
+
+private:
+    CheckpointOptions options_;
+    OnElement onElement_;
+    std::size_t every_ = 1;
+    std::unique_ptr<AsyncCheckpointer> writer_;
+};
+
+template <class Sketch, class OnElement = NoProgressHook>
+std::vector<StepResult> processOneStreamResumable(
+    const std::vector<std::string>& stream,
+    const HashFunc& h,
+    Sketch& sketch,
+    const std::vector<std::size_t>& steps,
+    const CheckpointOptions& options,
+    OnElement onElement = OnElement()
+) {
+    return processOneStream(stream, h, sketch, steps, CheckpointHooks<OnElement>(options, std::move(onElement)));
+}
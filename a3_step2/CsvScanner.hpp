@@ -0,0 +1,116 @@
+#pragma once
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Потоковое чтение CSV: файл читается блоками, строки и поля отдаются как string_view
+// в буфер, без выделений на каждую строку/поле. Поля обрезаются от пробелов.
+// Числа допускают запятую как десятичный разделитель (формат Excel из ReportWriter).
+class CsvScanner {
+public:
+    explicit CsvScanner(const std::string& path, char delim = ';')
+        : f_(std::fopen(path.c_str(), "rb"), &std::fclose), delim_(delim), path_(path) {
+        if (!f_) throw std::runtime_error("Cannot open: " + path);
+        buf_.resize(1 << 20);
+        fields_.reserve(16);
+    }
+
+    // Следующая строка; false — конец файла. Поля валидны до следующего вызова.
+    bool next() {
+        for (;;) {
+            const char* b = buf_.data() + pos_;
+            const char* nl = static_cast<const char*>(std::memchr(b, '\n', end_ - pos_));
+            if (nl) {
+                std::size_t len = nl - b;
+                pos_ += len + 1;
+                splitLine(std::string_view(b, len));
+                return true;
+            }
+            if (eof_) {
+                if (pos_ == end_) return false;
+                std::string_view line(b, end_ - pos_);
+                pos_ = end_;
+                splitLine(line);
+                return true;
+            }
+            refill();
+        }
+    }
+
+    std::size_t size() const { return fields_.size(); }
+    std::string_view field(std::size_t i) const { return fields_[i]; }
+    bool blank() const { return fields_.size() == 1 && fields_[0].empty(); }
+
+    double number(std::size_t i) const {
+        std::string_view s = fields_[i];
+        char tmp[64];
+        if (s.empty() || s.size() >= sizeof(tmp)) bad(s);
+        for (std::size_t k = 0; k < s.size(); ++k) tmp[k] = s[k] == ',' ? '.' : s[k];
+        double v = 0.0;
+        auto res = std::from_chars(tmp, tmp + s.size(), v);
+        if (res.ec != std::errc() || res.ptr != tmp + s.size()) bad(s);
+        return v;
+    }
+
+    int integer(std::size_t i) const {
+        std::string_view s = fields_[i];
+        int v = 0;
+        auto res = std::from_chars(s.data(), s.data() + s.size(), v);
+        if (res.ec != std::errc() || res.ptr != s.data() + s.size()) bad(s);
+        return v;
+    }
+
+private:
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> f_;
+    char delim_;
+    std::string path_;
+    std::vector<char> buf_;
+    std::size_t pos_ = 0;
+    std::size_t end_ = 0;
+    bool eof_ = false;
+    std::vector<std::string_view> fields_;
+
+    void refill() {
+        std::size_t keep = end_ - pos_;
+        std::memmove(buf_.data(), buf_.data() + pos_, keep);
+        pos_ = 0;
+        end_ = keep;
+        if (end_ == buf_.size()) buf_.resize(buf_.size() * 2);
+        std::size_t n = std::fread(buf_.data() + end_, 1, buf_.size() - end_, f_.get());
+        if (n == 0) {
+            if (std::ferror(f_.get())) throw std::runtime_error("Read error: " + path_);
+            eof_ = true;
+        }
+        end_ += n;
+    }
+
+    static std::string_view trim(std::string_view s) {
+        std::size_t a = 0, b = s.size();
+        while (a < b && (s[a] == ' ' || s[a] == '\t' || s[a] == '\r')) a++;
+        while (b > a && (s[b - 1] == ' ' || s[b - 1] == '\t' || s[b - 1] == '\r')) b--;
+        return s.substr(a, b - a);
+    }
+
+    void splitLine(std::string_view line) {
+        fields_.clear();
+        std::size_t start = 0;
+        for (;;) {
+            std::size_t stop = line.find(delim_, start);
+            if (stop == std::string_view::npos) {
+                fields_.push_back(trim(line.substr(start)));
+                return;
+            }
+            fields_.push_back(trim(line.substr(start, stop - start)));
+            start = stop + 1;
+        }
+    }
+
+    [[noreturn]] void bad(std::string_view s) const {
+        throw std::runtime_error("Bad number '" + std::string(s) + "' in " + path_);
+    }
+};
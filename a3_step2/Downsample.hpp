@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Прореживание рядов для графиков: число точек на ряд ограничено, форма сохраняется.
+using PlotPoint = std::pair<double, double>;
+
+// Largest-Triangle-Three-Buckets (Steinarsson, 2013): первая и последняя точки
+// сохраняются, из каждой корзины берётся точка с наибольшей площадью треугольника
+// с уже выбранной точкой и средним следующей корзины.
+inline std::vector<PlotPoint> lttb(const std::vector<PlotPoint>& pts, std::size_t threshold) {
+    const std::size_t n = pts.size();
+    if (threshold >= n || threshold < 3) return pts;
+
+    std::vector<PlotPoint> out;
+    out.reserve(threshold);
+    out.push_back(pts[0]);
+
+    const double every = static_cast<double>(n - 2) / static_cast<double>(threshold - 2);
+    std::size_t a = 0;
+    for (std::size_t i = 0; i < threshold - 2; ++i) {
+        std::size_t avgStart = static_cast<std::size_t>(std::floor((i + 1) * every)) + 1;
+        std::size_t avgEnd = std::min(static_cast<std::size_t>(std::floor((i + 2) * every)) + 1, n);
+        double avgX = 0.0, avgY = 0.0;
+        for (std::size_t k = avgStart; k < avgEnd; ++k) {
+            avgX += pts[k].first;
+            avgY += pts[k].second;
+        }
+        double cnt = static_cast<double>(std::max<std::size_t>(avgEnd - avgStart, 1));
+        avgX /= cnt;
+        avgY /= cnt;
+
+        std::size_t from = static_cast<std::size_t>(std::floor(i * every)) + 1;
+        std::size_t to = static_cast<std::size_t>(std::floor((i + 1) * every)) + 1;
+        double best = -1.0;
+        std::size_t pick = from;
+        for (std::size_t k = from; k < to; ++k) {
+            double area = std::fabs((pts[a].first - avgX) * (pts[k].second - pts[a].second) -
+                                    (pts[a].first - pts[k].first) * (avgY - pts[a].second));
+            if (area > best) {
+                best = area;
+                pick = k;
+            }
+        }
+        out.push_back(pts[pick]);
+        a = pick;
+    }
+
+    out.push_back(pts[n - 1]);
+    return out;
+}
+
+// Огибающая полосы: в каждой корзине максимум верхней и минимум нижней границы,
+// по две точки на корзину (её левый и правый x), чтобы выбросы не пропадали.
+inline void minMaxEnvelope(const std::vector<PlotPoint>& upper, const std::vector<PlotPoint>& lower,
+                           std::size_t maxPoints,
+                           std::vector<PlotPoint>& upperOut, std::vector<PlotPoint>& lowerOut) {
+    const std::size_t n = std::min(upper.size(), lower.size());
+    std::size_t buckets = maxPoints / 2;
+    if (n <= maxPoints || buckets == 0) {
+        upperOut.assign(upper.begin(), upper.begin() + n);
+        lowerOut.assign(lower.begin(), lower.begin() + n);
+        return;
+    }
+
+    upperOut.clear();
+    lowerOut.clear();
+    for (std::size_t b = 0; b < buckets; ++b) {
+        std::size_t from = n * b / buckets;
+        std::size_t to = n * (b + 1) / buckets;
+        double hi = upper[from].second, lo = lower[from].second;
+        for (std::size_t k = from + 1; k < to; ++k) {
+            hi = std::max(hi, upper[k].second);
+            lo = std::min(lo, lower[k].second);
+        }
+        double x0 = upper[from].first, x1 = upper[to - 1].first;
+        upperOut.push_back({x0, hi});
+        upperOut.push_back({x1, hi});
+        lowerOut.push_back({x0, lo});
+        lowerOut.push_back({x1, lo});
+    }
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#include "HashFuncGen.hpp"
+#include "CardinalitySketch.hpp"
+#include "Instrumentation.hpp"
+
+struct StepResult {
+    std::size_t processed = 0;
+    std::size_t F0 = 0;
+    double Nt = 0.0;
+    // Заполняются для скетчей с estimateWithError (HyperLogLog), иначе 0.
+    double stdErr = 0.0;
+    double groupStdErr = 0.0;
+    double lower = 0.0;
+    double upper = 0.0;
+};
+
+// Число групп регистров для проверки стохастическим усреднением на шагах processOneStream.
+constexpr std::uint32_t kErrorCheckGroups = 16;
+
+template <class Sketch, class = void>
+struct HasErrorEstimate : std::false_type {};
+
+template <class Sketch>
+struct HasErrorEstimate<Sketch, std::void_t<decltype(std::declval<const Sketch&>().estimateWithError())>>
+    : std::true_type {};
+
+inline double mean(const std::vector<double>& a) {
+    double s = 0.0;
+    for (double x : a) s += x;
+    return s / a.size();
+}
+
+inline double sampleStd(const std::vector<double>& a) {
+    if (a.size() < 2) return 0.0;
+    double m = mean(a);
+    double ss = 0.0;
+    for (double x : a) {
+        double d = x - m;
+        ss += d * d;
+    }
+    return std::sqrt(ss / (a.size() - 1));
+}
+
+// Точки расширения processOneStream; по умолчанию пустые и после инлайна исчезают.
+// resume() может восстановить скетч, готовые результаты и номер шага и вернуть,
+// с какого элемента продолжать; afterElement() вызывается после каждого элемента,
+// кроме последнего обработанного; finish() — по завершении. См. Checkpoint.hpp.
+struct NoStreamHooks {
+    template <class Sketch>
+    std::size_t resume(const std::vector<std::string>&, const HashFunc&, const std::vector<std::size_t>&,
+                       Sketch&, std::vector<StepResult>&, std::size_t&) {
+        return 0;
+    }
+    template <class Sketch>
+    void afterElement(std::size_t, const Sketch&, std::size_t, const std::vector<StepResult>&) {}
+    void finish() {}
+};
+
+// Прогоняет поток через скетч, на каждом шаге steps фиксирует точное F0 и оценку.
+// Sketch — любой final-наследник CardinalitySketch, вызовы addHash/estimate не виртуальные.
+template <class Sketch, class Hooks = NoStreamHooks>
+std::vector<StepResult> processOneStream(
+    const std::vector<std::string>& stream,
+    const HashFunc& h,
+    Sketch& sketch,
+    const std::vector<std::size_t>& steps,
+    Hooks&& hooks = Hooks()
+) {
+    static_assert(std::is_base_of<CardinalitySketch, Sketch>::value,
+                  "Sketch must implement CardinalitySketch");
+
+    std::unordered_set<std::string> uniq;
+    uniq.reserve(stream.size());
+
+    sketch.reset();
+
+    std::vector<StepResult> out;
+    out.reserve(steps.size());
+
+    std::size_t stepIdx = 0;
+    const std::size_t start = hooks.resume(stream, h, steps, sketch, out, stepIdx);
+    // точное F0 — оракул эксперимента, а не состояние скетча: при продолжении оно
+    // пересобирается проходом по уже обработанному префиксу
+    for (std::size_t i = 0; i < start; ++i) uniq.insert(stream[i]);
+    if (stepIdx >= steps.size()) {
+        hooks.finish();
+        return out;
+    }
+    std::size_t nextStop = steps[stepIdx];
+
+    for (std::size_t i = start; i < stream.size(); ++i) {
+        const auto& s = stream[i];
+
+        {
+            SET5_TIME_SCOPE(exactTimer, ExactCycles);
+#ifdef SET5_INSTRUMENT
+            std::size_t buckets = uniq.bucket_count();
+#endif
+            uniq.insert(s);
+            SET5_COUNT(ExactInserts, 1);
+            SET5_COUNT(ExactRehashes, uniq.bucket_count() != buckets);
+        }
+
+        std::uint32_t x;
+        {
+            SET5_TIME_SCOPE(hashTimer, HashCycles);
+            x = h(s);
+        }
+        {
+            SET5_TIME_SCOPE(sketchTimer, HllCycles);
+            sketch.addHash(x);
+        }
+
+        std::size_t processed = i + 1;
+        if (processed == nextStop) {
+            StepResult r;
+            r.processed = processed;
+            r.F0 = uniq.size();
+            if constexpr (HasErrorEstimate<Sketch>::value) {
+                auto e = sketch.estimateWithError(1.96, kErrorCheckGroups);
+                r.Nt = e.estimate;
+                r.stdErr = e.stdError;
+                r.groupStdErr = e.groupStdError;
+                r.lower = e.lower;
+                r.upper = e.upper;
+            } else {
+                r.Nt = sketch.estimate();
+            }
+            out.push_back(r);
+
+            stepIdx++;
+            if (stepIdx >= steps.size()) break;
+            nextStop = steps[stepIdx];
+        }
+        hooks.afterElement(processed, sketch, stepIdx, out);
+    }
+    hooks.finish();
+    return out;
+}
+
+// Траектория: оценка и точное F0 после каждых stride элементов (stride = 1 — после каждого).
+// Точное F0 считается по первым вхождениям (счётчик растёт, только если insert добавил
+// элемент), поэтому шаг стоит O(1) плюс estimate(); для HyperLogLog это тоже O(1).
+// Точки не копятся: каждая сразу отдаётся в emit(const StepResult&).
+template <class Sketch, class Emit>
+void processTrajectory(
+    const std::vector<std::string>& stream,
+    const HashFunc& h,
+    Sketch& sketch,
+    std::size_t stride,
+    Emit&& emit
+) {
+    static_assert(std::is_base_of<CardinalitySketch, Sketch>::value,
+                  "Sketch must implement CardinalitySketch");
+    if (stride == 0) stride = 1;
+
+    std::unordered_set<std::string_view> seen;
+    seen.reserve(stream.size());
+    std::size_t F0 = 0;
+
+    sketch.reset();
+
+    std::size_t nextStop = stride;
+    for (std::size_t i = 0; i < stream.size(); ++i) {
+        std::string_view s = stream[i];
+        F0 += seen.insert(s).second;
+        sketch.addHash(h(s));
+
+        if (i + 1 == nextStop || i + 1 == stream.size()) {
+            StepResult r;
+            r.processed = i + 1;
+            r.F0 = F0;
+            r.Nt = sketch.estimate();
+            emit(static_cast<const StepResult&>(r));
+            nextStop += stride;
+        }
+    }
+}
@@ -1,26 +1,30 @@
 #pragma once
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <random>
 #include <vector>
 #include <stdexcept>
 
+#include "Instrumentation.hpp"
+
 class HashFunc {
 public:
     explicit HashFunc(std::uint64_t seed) : seed_(seed) {}
 
-    std::uint32_t operator()(const std::string& s) const {
+    std::uint32_t operator()(std::string_view s) const {
+        SET5_COUNT(HashCalls, 1);
         std::uint64_t h = 14695981039346656037ULL ^ seed_;
         for (unsigned char c : s) {
             h ^= static_cast<std::uint64_t>(c);
             h *= 1099511628211ULL;
         }
-
         h = mix64(h);
-
         return static_cast<std::uint32_t>(h & 0xFFFFFFFFULL);
     }
 
+    std::uint64_t seed() const { return seed_; }
+
 private:
     std::uint64_t seed_;
 
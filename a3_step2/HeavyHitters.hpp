@@ -0,0 +1,258 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "HashFuncGen.hpp"
+#include "CardinalitySketch.hpp"
+
+// SpaceSaving (Metwally et al.): k счётчиков на самые частые ключи. Для любого ключа
+// count - error <= истинная частота <= count, а каждый ключ с частотой > N / k точно попадает в список.
+// Поиск — открытая адресация по уже посчитанному 32-битному хешу (тот же, что уходит в HLL),
+// строки сравниваются только при совпадении хеша. Счётчики хранятся в Stream-Summary:
+// список корзин с равным count по возрастанию, в каждой — список её счётчиков. Минимум —
+// голова списка корзин; +1 переносит счётчик в соседнюю корзину за O(1), новый ключ
+// и вытеснение — тоже O(1). Прибавка n > 1 идёт вперёд по корзинам со count меньше нового.
+// Списки — индексы в массивах, без выделений памяти на обновление.
+class SpaceSaving {
+public:
+    struct Item {
+        std::string key;
+        std::uint64_t count = 0;
+        std::uint64_t error = 0; // завышение count сверху (значение вытесненного счётчика)
+    };
+
+    explicit SpaceSaving(std::size_t k) : k_(k) {
+        if (k_ == 0 || k_ > (1u << 30)) throw std::invalid_argument("SpaceSaving: k must be in [1..2^30]");
+        std::size_t cap = 1;
+        while (cap < 2 * k_) cap <<= 1;
+        table_.assign(cap, Slot{0, kNil});
+        mask_ = static_cast<std::uint32_t>(cap - 1);
+        counters_.reserve(k_);
+        buckets_.reserve(k_ + 1);
+    }
+
+    void reset() {
+        std::fill(table_.begin(), table_.end(), Slot{0, kNil});
+        counters_.clear();
+        buckets_.clear();
+        freeBuckets_.clear();
+        minBucket_ = maxBucket_ = kNil;
+        total_ = 0;
+    }
+
+    // Подтянуть в кэш ячейку таблицы заранее (пакетное обновление).
+    void prefetch(std::uint32_t hash) const { __builtin_prefetch(&table_[hash & mask_]); }
+
+    void add(std::string_view key, std::uint32_t hash, std::uint64_t n = 1) {
+        if (n == 0) return;
+        total_ += n;
+        std::uint32_t pos = hash & mask_;
+        for (; table_[pos].id != kNil; pos = (pos + 1) & mask_) {
+            if (table_[pos].hash != hash) continue;
+            std::uint32_t id = table_[pos].id;
+            if (counters_[id].key == key) {
+                bump(id, n);
+                return;
+            }
+        }
+
+        if (counters_.size() < k_) {
+            std::uint32_t id = static_cast<std::uint32_t>(counters_.size());
+            counters_.push_back(Counter{std::string(key), hash, kNil, kNil, kNil, 0});
+            table_[pos] = Slot{hash, id};
+            attach(id, bucketAfter(kNil, n));
+            return;
+        }
+
+        // вытесняем минимальный счётчик: новый ключ наследует его значение как ошибку
+        std::uint32_t id = buckets_[minBucket_].first;
+        Counter& c = counters_[id];
+        erase(id);
+        c.key.assign(key.data(), key.size());
+        c.hash = hash;
+        c.error = buckets_[minBucket_].count;
+        insert(id);
+        bump(id, n);
+    }
+
+    // Не больше n ключей по убыванию count.
+    std::vector<Item> top(std::size_t n) const {
+        std::vector<Item> out;
+        for (std::uint32_t b = maxBucket_; b != kNil && out.size() < n; b = buckets_[b].prev) {
+            for (std::uint32_t id = buckets_[b].first; id != kNil && out.size() < n; id = counters_[id].next) {
+                out.push_back(Item{counters_[id].key, buckets_[b].count, counters_[id].error});
+            }
+        }
+        return out;
+    }
+
+    std::size_t capacity() const { return k_; }
+    std::uint64_t total() const { return total_; }
+
+    std::size_t memoryBytes() const {
+        std::size_t bytes = table_.size() * sizeof(Slot) + counters_.capacity() * sizeof(Counter) +
+                            buckets_.capacity() * sizeof(Bucket) + freeBuckets_.capacity() * sizeof(std::uint32_t);
+        for (const auto& c : counters_) bytes += c.key.capacity() > 15 ? c.key.capacity() + 1 : 0;
+        return bytes;
+    }
+
+private:
+    static constexpr std::uint32_t kNil = 0xFFFFFFFFu;
+
+    struct Counter {
+        std::string key;
+        std::uint32_t hash;
+        std::uint32_t bucket;
+        std::uint32_t prev; // соседи по корзине
+        std::uint32_t next;
+        std::uint64_t error;
+    };
+
+    struct Bucket {
+        std::uint64_t count;
+        std::uint32_t first; // список счётчиков
+        std::uint32_t prev;  // соседние корзины, count по возрастанию
+        std::uint32_t next;
+    };
+
+    std::size_t k_;
+    std::uint32_t mask_;
+    // хеш рядом с индексом: пробирование не трогает счётчики
+    struct Slot {
+        std::uint32_t hash;
+        std::uint32_t id; // kNil — пусто
+    };
+
+    std::vector<Slot> table_;
+    std::vector<Counter> counters_;
+    std::vector<Bucket> buckets_;
+    std::vector<std::uint32_t> freeBuckets_;
+    std::uint32_t minBucket_ = kNil;
+    std::uint32_t maxBucket_ = kNil;
+    std::uint64_t total_ = 0;
+
+    // Корзина со значением c, первая подходящая после from (kNil — от начала списка);
+    // если такой нет, создаётся на своём месте.
+    std::uint32_t bucketAfter(std::uint32_t from, std::uint64_t c) {
+        std::uint32_t prev = from;
+        std::uint32_t next = from == kNil ? minBucket_ : buckets_[from].next;
+        while (next != kNil && buckets_[next].count < c) {
+            prev = next;
+            next = buckets_[next].next;
+        }
+        if (next != kNil && buckets_[next].count == c) return next;
+
+        std::uint32_t b;
+        if (!freeBuckets_.empty()) {
+            b = freeBuckets_.back();
+            freeBuckets_.pop_back();
+        } else {
+            b = static_cast<std::uint32_t>(buckets_.size());
+            buckets_.push_back(Bucket{});
+        }
+        buckets_[b] = Bucket{c, kNil, prev, next};
+        (prev == kNil ? minBucket_ : buckets_[prev].next) = b;
+        (next == kNil ? maxBucket_ : buckets_[next].prev) = b;
+        return b;
+    }
+
+    void attach(std::uint32_t id, std::uint32_t b) {
+        Counter& c = counters_[id];
+        c.bucket = b;
+        c.prev = kNil;
+        c.next = buckets_[b].first;
+        if (c.next != kNil) counters_[c.next].prev = id;
+        buckets_[b].first = id;
+    }
+
+    // Снимает счётчик с корзины; опустевшая корзина уходит из списка.
+    void detach(std::uint32_t id) {
+        Counter& c = counters_[id];
+        const std::uint32_t b = c.bucket;
+        (c.prev == kNil ? buckets_[b].first : counters_[c.prev].next) = c.next;
+        if (c.next != kNil) counters_[c.next].prev = c.prev;
+        if (buckets_[b].first != kNil) return;
+        const Bucket& bk = buckets_[b];
+        (bk.prev == kNil ? minBucket_ : buckets_[bk.prev].next) = bk.next;
+        (bk.next == kNil ? maxBucket_ : buckets_[bk.next].prev) = bk.prev;
+        freeBuckets_.push_back(b);
+    }
+
+    // count += n: корзина ищется до снятия счётчика, пока его корзина ещё в списке.
+    void bump(std::uint32_t id, std::uint64_t n) {
+        const std::uint32_t b = counters_[id].bucket;
+        const std::uint32_t dst = bucketAfter(b, buckets_[b].count + n);
+        detach(id);
+        attach(id, dst);
+    }
+
+    void insert(std::uint32_t id) {
+        std::uint32_t hash = counters_[id].hash;
+        std::uint32_t pos = hash & mask_;
+        while (table_[pos].id != kNil) pos = (pos + 1) & mask_;
+        table_[pos] = Slot{hash, id};
+    }
+
+    // Удаление из линейного пробирования со сдвигом хвоста назад, без надгробий.
+    void erase(std::uint32_t id) {
+        std::uint32_t pos = counters_[id].hash & mask_;
+        while (table_[pos].id != id) pos = (pos + 1) & mask_;
+        std::uint32_t hole = pos;
+        for (std::uint32_t next = (hole + 1) & mask_; table_[next].id != kNil; next = (next + 1) & mask_) {
+            std::uint32_t home = table_[next].hash & mask_;
+            // элемент можно сдвинуть в дыру, если его домашняя ячейка не лежит в (hole, next]
+            if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+                table_[hole] = table_[next];
+                hole = next;
+            }
+        }
+        table_[hole].id = kNil;
+    }
+};
+
+// Один проход: каждый элемент хешируется один раз, хеш идёт и в скетч уникальных,
+// и в SpaceSaving. Пакетный режим сначала хеширует пачку, затем обновляет обе
+// структуры в одном цикле, заранее подтягивая ячейки таблицы SpaceSaving.
+template <class Sketch>
+class DistinctTopK {
+public:
+    static_assert(std::is_base_of<CardinalitySketch, Sketch>::value,
+                  "Sketch must implement CardinalitySketch");
+
+    DistinctTopK(const HashFunc& h, Sketch& distinct, SpaceSaving& top)
+        : h_(h), distinct_(distinct), top_(top) {}
+
+    void add(std::string_view s) {
+        std::uint32_t x = h_(s);
+        distinct_.addHash(x);
+        top_.add(s, x);
+    }
+
+    template <class Str>
+    void addBatch(const Str* keys, std::size_t n) {
+        for (std::size_t off = 0; off < n; off += kBatch) {
+            const std::size_t len = std::min(kBatch, n - off);
+            const Str* batch = keys + off;
+            for (std::size_t i = 0; i < len; ++i) hashes_[i] = h_(std::string_view(batch[i]));
+            for (std::size_t i = 0; i < len; ++i) {
+                if (i + kPrefetch < len) top_.prefetch(hashes_[i + kPrefetch]);
+                distinct_.addHash(hashes_[i]);
+                top_.add(std::string_view(batch[i]), hashes_[i]);
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t kBatch = 256;
+    static constexpr std::size_t kPrefetch = 8;
+
+    HashFunc h_;
+    Sketch& distinct_;
+    SpaceSaving& top_;
+    std::uint32_t hashes_[kBatch];
+};
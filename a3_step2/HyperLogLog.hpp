@@ -0,0 +1,267 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "CardinalitySketch.hpp"
+#include "Instrumentation.hpp"
+#include "RegisterAllocator.hpp"
+
+// Оценка с погрешностью по состоянию регистров, без повторных прогонов.
+struct EstimateWithError {
+    double estimate = 0.0;
+    double stdError = 0.0;     // абсолютная стандартная ошибка по теории
+    double lower = 0.0;        // estimate -+ z * stdError, нижняя граница не меньше 0
+    double upper = 0.0;
+    bool linearCounting = false;
+    // Проверка стохастическим усреднением: регистры делятся на groups подскетчей,
+    // их разброс пересчитывается к полному m. 0 — проверка не запрашивалась.
+    double groupStdError = 0.0;
+};
+
+class HyperLogLog final : public CardinalitySketch {
+public:
+    // arena — откуда брать память регистров (RegisterArena из RegisterMemory.hpp: huge pages,
+    // узел NUMA); nullptr — обычная куча.
+    explicit HyperLogLog(int B, RegisterSource* arena = nullptr)
+        : B_(B), m_(1u << B), regs_(m_, 0, RegisterAllocator<std::uint8_t>(arena)) {
+        if (B_ <= 0 || B_ >= 31) throw std::invalid_argument("B must be in [1..30]");
+        L_ = 32 - B_;
+        atMin_ = m_;
+        zeros_ = m_;
+        zScaled_ = static_cast<std::uint64_t>(m_) << kZShift;
+    }
+
+    void reset() override {
+        std::fill(regs_.begin(), regs_.end(), 0);
+        minReg_ = 0;
+        atMin_ = m_;
+        skipFrom_ = 1ULL << 32;
+        zeros_ = m_;
+        zScaled_ = static_cast<std::uint64_t>(m_) << kZShift;
+    }
+
+    void addHash(std::uint32_t x) override {
+        SET5_COUNT(HllAdds, 1);
+        std::uint32_t w = x << B_;
+
+        // rho(w) <= minReg_  <=>  w >= skipFrom_: такой хеш не поднимет ни один регистр
+        if (w >= skipFrom_) {
+            SET5_COUNT(HllFastSkips, 1);
+            return;
+        }
+
+        std::uint32_t idx = x >> (32 - B_);
+        std::uint8_t r = rho(w, L_);
+        std::uint8_t cur = regs_[idx];
+        SET5_COUNT(HllRegisterChanges, r > cur);
+        std::uint8_t nv = std::max(cur, r);
+        regs_[idx] = nv;
+
+        // сумма для estimate() без ветвлений: при nv == cur вклад нулевой; r >= 1, поэтому
+        // нулевой регистр всегда поднимается
+        zScaled_ -= (1ULL << (kZShift - cur)) - (1ULL << (kZShift - nv));
+        zeros_ -= (cur == 0);
+
+        // ветвление почти всегда предсказуемо: регистров на минимуме мало
+        if (cur == minReg_ && r > cur && --atMin_ == 0) recomputeMin();
+    }
+
+    // O(1): Z = sum 2^-reg и число нулевых регистров поддерживаются в addHash.
+    double estimate() const override {
+        return estimateFrom(std::ldexp(static_cast<double>(zScaled_), -kZShift),
+                            static_cast<int>(zeros_), m_);
+    }
+
+    // Погрешность: 1.04 / sqrt(m) в диапазоне сырой оценки, а для linear counting —
+    // дисперсия m (e^t - t - 1), t = n / m (Whang et al.), она заметно меньше при малых n.
+    // groups > 1 (степень двойки, m / groups >= 16) добавляет проверку по группам регистров, O(m).
+    EstimateWithError estimateWithError(double z = 1.96, std::uint32_t groups = 0) const {
+        EstimateWithError r;
+        const double m = static_cast<double>(m_);
+        const double Z = std::ldexp(static_cast<double>(zScaled_), -kZShift);
+        r.estimate = estimateFrom(Z, static_cast<int>(zeros_), m_);
+        r.linearCounting = alpha_m(m_) * m * m / Z <= 2.5 * m && zeros_ > 0;
+        if (r.linearCounting) {
+            double t = r.estimate / m;
+            r.stdError = std::sqrt(m * (std::exp(t) - t - 1.0));
+        } else {
+            r.stdError = 1.04 / std::sqrt(m) * r.estimate;
+        }
+        r.lower = std::max(0.0, r.estimate - z * r.stdError);
+        r.upper = r.estimate + z * r.stdError;
+
+        if (groups > 1) {
+            if ((groups & (groups - 1)) != 0 || m_ / groups < 16) {
+                throw std::invalid_argument("HyperLogLog: groups must be a power of two with m / groups >= 16");
+            }
+            // Группа — HLL с m / groups регистрами над своей ~1/groups долей потока.
+            const std::uint32_t gm = m_ / groups;
+            double sum = 0.0, sumSq = 0.0;
+            for (std::uint32_t g = 0; g < groups; ++g) {
+                double gz = 0.0;
+                int gv = 0;
+                for (std::uint32_t i = g * gm; i < (g + 1) * gm; ++i) {
+                    gz += std::ldexp(1.0, -static_cast<int>(regs_[i]));
+                    gv += regs_[i] == 0;
+                }
+                double e = estimateFrom(gz, gv, gm);
+                sum += e;
+                sumSq += e * e;
+            }
+            double mean = sum / groups;
+            double var = (sumSq - groups * mean * mean) / (groups - 1);
+            // относительный разброс группы делится на sqrt(groups): регистров в groups раз больше
+            if (mean > 0.0) r.groupStdError = std::sqrt(std::max(var, 0.0)) / mean / std::sqrt(double(groups)) * r.estimate;
+        }
+        return r;
+    }
+
+    // Формула HLL с поправками для малых и больших значений по сумме Z = sum 2^-reg
+    // и числу нулевых регистров V. Вынесена отдельно для вариантов с другим хранением регистров.
+    static double estimateFrom(double Z, int V, std::uint32_t m) {
+        double E = alpha_m(m) * (static_cast<double>(m) * static_cast<double>(m)) / Z;
+
+        if (E <= 2.5 * m && V > 0) {
+            E = static_cast<double>(m) * std::log(static_cast<double>(m) / V);
+        }
+
+        const double two32 = 4294967296.0; // 2^32
+        if (E > two32 / 30.0 && E < two32) {
+            E = -two32 * std::log(1.0 - E / two32);
+        }
+        return E;
+    }
+
+    std::size_t memoryBytes() const override { return regs_.size(); }
+    std::string name() const override { return "HLL(B=" + std::to_string(B_) + ")"; }
+
+    int B() const { return B_; }
+    std::uint32_t m() const { return m_; }
+    std::uint8_t minRegister() const { return minReg_; }
+
+    const std::uint8_t* registers() const { return regs_.data(); }
+    RegisterSource* arena() const { return regs_.get_allocator().source(); }
+
+    // Заменяет регистры m() байтами из src (например, прочитанными из файла).
+    void loadRegisters(const std::uint8_t* src) {
+        for (std::uint32_t i = 0; i < m_; ++i) {
+            if (src[i] > L_ + 1) throw std::invalid_argument("HyperLogLog: register value out of range");
+        }
+        std::copy(src, src + m_, regs_.begin());
+        recomputeMin();
+        recomputeSums();
+    }
+
+    // regs[idx] = max(regs[idx], v) с поддержкой сумм для estimate(): O(1), для применения
+    // разреженных обновлений (пары индекс/значение) без сборки целого скетча.
+    void raiseRegister(std::uint32_t idx, std::uint8_t v) {
+        if (idx >= m_) throw std::invalid_argument("HyperLogLog: register index out of range");
+        if (v > L_ + 1) throw std::invalid_argument("HyperLogLog: register value out of range");
+        std::uint8_t cur = regs_[idx];
+        if (v <= cur) return;
+        regs_[idx] = v;
+        zScaled_ -= (1ULL << (kZShift - cur)) - (1ULL << (kZShift - v));
+        zeros_ -= (cur == 0);
+        if (cur == minReg_ && --atMin_ == 0) recomputeMin();
+    }
+
+    // Объединение скетчей одного B, построенных одной хеш-функцией: поэлементный max.
+    void merge(const HyperLogLog& other) {
+        if (other.B_ != B_) throw std::invalid_argument("HyperLogLog: cannot merge sketches with different B");
+        for (std::uint32_t i = 0; i < m_; ++i) {
+            regs_[i] = std::max(regs_[i], other.regs_[i]);
+        }
+        recomputeMin();
+        recomputeSums();
+    }
+
+    // Тот же скетч с меньшей точностью newB <= B, как если бы поток сразу считали с newB:
+    // старший хвост индекса (d — младшие B - newB бит idx) переходит в начало w.
+    // Регистр группы = max по её регистрам: 0 для пустого, позиция старшей единицы d при
+    // d != 0, иначе (B - newB) + reg. Нужен, чтобы освобождать память без перечитывания потока.
+    HyperLogLog folded(int newB) const {
+        if (newB <= 0 || newB > B_) throw std::invalid_argument("HyperLogLog: fold target must be in [1..B]");
+        HyperLogLog out(newB, arena());
+        const int shift = B_ - newB;
+        const std::uint8_t cap = static_cast<std::uint8_t>(out.L_ + 1);
+        for (std::uint32_t i = 0; i < m_; ++i) {
+            std::uint8_t reg = regs_[i];
+            if (reg == 0) continue;
+            std::uint32_t d = i & ((1u << shift) - 1);
+            int v = d != 0 ? __builtin_clz(d) - (32 - shift) + 1 : shift + reg;
+            std::uint8_t& dst = out.regs_[i >> shift];
+            dst = std::max(dst, std::min(static_cast<std::uint8_t>(v), cap));
+        }
+        out.recomputeMin();
+        out.recomputeSums();
+        return out;
+    }
+
+    static double alpha_m(std::uint32_t m) {
+        if (m == 16) return 0.673;
+        if (m == 32) return 0.697;
+        if (m == 64) return 0.709;
+        return 0.7213 / (1.0 + 1.079 / static_cast<double>(m));
+    }
+
+    static std::uint8_t rho(std::uint32_t w, int L) {
+        if (w == 0) return static_cast<std::uint8_t>(L + 1);
+
+        int r = __builtin_clz(w) + 1;
+        if (r > L + 1) r = L + 1;
+        return static_cast<std::uint8_t>(r);
+    }
+
+private:
+    int B_;
+    int L_;
+    std::uint32_t m_;
+    std::vector<std::uint8_t, RegisterAllocator<std::uint8_t>> regs_;
+
+    // Фильтр включается, когда отсекает не меньше 1 - 2^-4 хешей: при меньшей доле
+    // непредсказуемое ветвление обходится дороже безусловной записи.
+    static constexpr std::uint8_t kSkipMinRegister = 4;
+
+    // Минимальное значение регистра, сколько регистров его имеют,
+    // и порог на w = x << B, начиная с которого rho(w) <= minReg_.
+    std::uint8_t minReg_ = 0;
+    std::uint32_t atMin_ = 0;
+    std::uint64_t skipFrom_ = 1ULL << 32;
+
+    // Z * 2^32 в целых: регистр не больше 32, поэтому каждое слагаемое 2^(32 - reg) — целое,
+    // а сумма не превосходит 2^30 * 2^32 и считается точно, без накопления ошибки.
+    static constexpr int kZShift = 32;
+    std::uint64_t zScaled_ = 0;
+    std::uint32_t zeros_ = 0;
+
+    void recomputeSums() {
+        zScaled_ = 0;
+        zeros_ = 0;
+        for (std::uint8_t reg : regs_) {
+            zScaled_ += 1ULL << (kZShift - reg);
+            zeros_ += (reg == 0);
+        }
+    }
+
+    // Вызывается, когда последний регистр со значением minReg_ поднялся:
+    // не чаще L + 1 раз за жизнь скетча.
+    void recomputeMin() {
+        std::uint8_t mn = regs_[0];
+        std::uint32_t cnt = 0;
+        for (std::uint8_t reg : regs_) {
+            if (reg < mn) {
+                mn = reg;
+                cnt = 0;
+            }
+            if (reg == mn) cnt++;
+        }
+        minReg_ = mn;
+        atMin_ = cnt;
+        if (minReg_ < kSkipMinRegister) skipFrom_ = 1ULL << 32;
+        else skipFrom_ = minReg_ > L_ ? 0 : (1ULL << (32 - minReg_));
+    }
+};
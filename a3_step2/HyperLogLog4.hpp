@@ -0,0 +1,106 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "HyperLogLog.hpp"
+
+// HLL с 4-битными регистрами: значение регистра = base + nibble.
+// Когда все nibble становятся ненулевыми, base увеличивается, а все nibble уменьшаются на 1.
+// Значения выше base + 15 обрезаются — при 32-битном хеше это почти не влияет на точность,
+// а память вдвое меньше, чем у HyperLogLog.
+class HyperLogLog4 final : public CardinalitySketch {
+public:
+    explicit HyperLogLog4(int B)
+        : B_(B), m_(1u << B), nibbles_((m_ + 1) / 2, 0), zeros_(m_) {
+        if (B_ <= 0 || B_ >= 31) throw std::invalid_argument("B must be in [1..30]");
+        L_ = 32 - B_;
+    }
+
+    void reset() override {
+        std::fill(nibbles_.begin(), nibbles_.end(), 0);
+        base_ = 0;
+        zeros_ = m_;
+    }
+
+    void addHash(std::uint32_t x) override {
+        std::uint32_t idx = x >> (32 - B_);
+        std::uint32_t w = x << B_;
+
+        int r = HyperLogLog::rho(w, L_);
+        if (r <= base_) return;
+
+        int v = std::min(r - base_, 15);
+        int cur = get(idx);
+        if (v <= cur) return;
+
+        if (cur == 0) zeros_--;
+        set(idx, v);
+        if (zeros_ == 0) rebase();
+    }
+
+    double estimate() const override {
+        double Z = 0.0;
+        for (std::uint32_t i = 0; i < m_; ++i) {
+            Z += std::ldexp(1.0, -(base_ + get(i)));
+        }
+        int V = base_ == 0 ? static_cast<int>(zeros_) : 0;
+        return HyperLogLog::estimateFrom(Z, V, m_);
+    }
+
+    std::size_t memoryBytes() const override { return nibbles_.size(); }
+    std::string name() const override { return "HLL4(B=" + std::to_string(B_) + ")"; }
+
+    int B() const { return B_; }
+    std::uint32_t m() const { return m_; }
+    int base() const { return base_; }
+
+    // Значения регистров (base + nibble) в m байт dst.
+    void copyRegisters(std::uint8_t* dst) const {
+        for (std::uint32_t i = 0; i < m_; ++i) dst[i] = static_cast<std::uint8_t>(base_ + get(i));
+    }
+
+    // Заменяет регистры m байтами src: base — минимум, что выше base + 15, обрезается.
+    void loadRegisters(const std::uint8_t* src) {
+        base_ = *std::min_element(src, src + m_);
+        zeros_ = 0;
+        for (std::uint32_t i = 0; i < m_; ++i) {
+            int v = std::min(src[i] - base_, 15);
+            set(i, v);
+            zeros_ += v == 0;
+        }
+    }
+
+private:
+    int B_;
+    int L_;
+    std::uint32_t m_;
+    std::vector<std::uint8_t> nibbles_;
+    int base_ = 0;
+    std::uint32_t zeros_;
+
+    int get(std::uint32_t i) const {
+        std::uint8_t b = nibbles_[i >> 1];
+        return (i & 1) ? (b >> 4) : (b & 0x0F);
+    }
+
+    void set(std::uint32_t i, int v) {
+        std::uint8_t& b = nibbles_[i >> 1];
+        if (i & 1) b = static_cast<std::uint8_t>((b & 0x0F) | (v << 4));
+        else       b = static_cast<std::uint8_t>((b & 0xF0) | v);
+    }
+
+    void rebase() {
+        while (zeros_ == 0) {
+            base_++;
+            for (std::uint32_t i = 0; i < m_; ++i) {
+                int v = get(i) - 1;
+                set(i, v);
+                if (v == 0) zeros_++;
+            }
+        }
+    }
+};
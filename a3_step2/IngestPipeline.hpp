@@ -0,0 +1,257 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "HashFuncGen.hpp"
+#include "CardinalitySketch.hpp"
+#include "SpscRing.hpp"
+#include "Instrumentation.hpp"
+#include "NumaTopology.hpp"
+
+// Конвейер чтение -> хеширование -> скетч.
+//
+//   reader ──blocks[j]──> hasher j ──batches[j]──> sketch (вызывающий поток)
+//          <─freeBlocks[j]─        <─freeBatches[j]─
+//
+// Читатель режет вход на блоки по границе строки и раздаёт их хешерам по кругу;
+// каждый хешер отдаёт пачку 32-битных хешей своей очереди. Все очереди — SpscRing,
+// поэтому заполненная очередь тормозит предыдущую стадию. Буферы возвращаются
+// обратно через free-очереди и переиспользуются без новых выделений.
+// Порядок применения хешей не сохраняется — для скетчей с max/min это не важно.
+struct PipelineConfig {
+    std::size_t blockSize = 1 << 20;
+    std::size_t hashers = 2;
+    std::size_t queueDepth = 8;
+    // >= 0: все потоки конвейера (и вызывающий на время run) работают на CPU этого
+    // узла NUMA — туда же, где арена регистров скетча (RegisterArena(..., numaNode)).
+    int numaNode = -1;
+};
+
+struct QueueStats {
+    std::string name;
+    std::size_t capacity = 0;
+    double meanOccupancy = 0.0;
+    std::size_t maxOccupancy = 0;
+    std::uint64_t producerStalls = 0;
+    std::uint64_t consumerStalls = 0;
+};
+
+struct PipelineStats {
+    std::uint64_t bytes = 0;
+    std::uint64_t lines = 0;
+    double seconds = 0.0;
+    std::vector<QueueStats> queues;
+
+    double mbPerSec() const { return seconds > 0 ? bytes / seconds / 1e6 : 0.0; }
+};
+
+class IngestPipeline {
+public:
+    explicit IngestPipeline(HashFunc h, PipelineConfig cfg = PipelineConfig())
+        : h_(h), cfg_(cfg) {
+        if (cfg_.hashers == 0) throw std::invalid_argument("IngestPipeline: hashers must be >= 1");
+        if (cfg_.blockSize == 0) throw std::invalid_argument("IngestPipeline: blockSize must be > 0");
+    }
+
+    template <class Sketch>
+    PipelineStats runFile(const std::string& path, Sketch& sketch) {
+        std::FILE* in = std::fopen(path.c_str(), "rb");
+        if (!in) throw std::runtime_error("Cannot open file for reading: " + path);
+        std::unique_ptr<std::FILE, int (*)(std::FILE*)> guard(in, &std::fclose);
+        return run(in, sketch);
+    }
+
+    template <class Sketch>
+    PipelineStats run(std::FILE* in, Sketch& sketch) {
+        static_assert(std::is_base_of<CardinalitySketch, Sketch>::value,
+                      "Sketch must implement CardinalitySketch");
+        return run(in, [&sketch](const std::uint32_t* x, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) sketch.addHash(x[i]);
+        });
+    }
+
+    // Общий вариант: apply(hashes, n) вызывается в потоке, запустившем run().
+    template <class Apply,
+              class = std::enable_if_t<!std::is_base_of<CardinalitySketch, std::decay_t<Apply>>::value>>
+    PipelineStats run(std::FILE* in, Apply&& apply) {
+        const std::size_t H = cfg_.hashers;
+        std::vector<std::unique_ptr<Lane>> lanes;
+        for (std::size_t j = 0; j < H; ++j) lanes.push_back(std::make_unique<Lane>(cfg_.queueDepth));
+
+        PipelineStats st;
+        bool readError = false;
+        auto t0 = std::chrono::steady_clock::now();
+
+        const int node = cfg_.numaNode;
+        topology::AffinityGuard callerAffinity;
+        if (node >= 0) topology::pinCurrentThreadToNode(node);
+
+        std::thread reader([&] {
+            if (node >= 0) topology::pinCurrentThreadToNode(node);
+            st.bytes = readBlocks(in, lanes, readError);
+        });
+        std::vector<std::thread> hashers;
+        for (std::size_t j = 0; j < H; ++j) {
+            hashers.emplace_back([this, &lanes, j, node] {
+                if (node >= 0) topology::pinCurrentThreadToNode(node);
+                hashBlocks(*lanes[j]);
+            });
+        }
+
+        std::size_t open = H;
+        std::vector<bool> done(H, false);
+        Batch b;
+        for (unsigned idle = 0; open > 0;) {
+            bool progress = false;
+            for (std::size_t j = 0; j < H; ++j) {
+                if (done[j]) continue;
+                Lane& lane = *lanes[j];
+                // closed() читается до tryPop: хешер закрывает очередь после последней пачки,
+                // поэтому неудачный tryPop после закрытия значит, что пачек больше не будет
+                const bool closed = lane.batches.closed();
+                if (lane.batches.tryPop(b)) {
+                    {
+                        SET5_TIME_SCOPE(sketchTimer, HllCycles);
+                        apply(b.data(), b.size());
+                    }
+                    st.lines += b.size();
+                    lane.freeBatches.tryPush(b);
+                    progress = true;
+                } else if (closed) {
+                    done[j] = true;
+                    open--;
+                }
+            }
+            if (progress) {
+                idle = 0;
+            } else {
+                sketchStalls_++;
+                if (++idle > 64) std::this_thread::yield();
+            }
+        }
+
+        reader.join();
+        for (auto& t : hashers) t.join();
+        st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (readError) throw std::runtime_error("IngestPipeline: read error");
+
+        for (std::size_t j = 0; j < H; ++j) {
+            st.queues.push_back(queueStats("blocks[" + std::to_string(j) + "]", lanes[j]->blocks));
+            st.queues.push_back(queueStats("batches[" + std::to_string(j) + "]", lanes[j]->batches));
+        }
+        return st;
+    }
+
+    // Сколько раз стадия скетча не нашла готовых пачек (за всё время жизни объекта).
+    std::uint64_t sketchStalls() const { return sketchStalls_; }
+
+private:
+    using Block = std::vector<char>;
+    using Batch = std::vector<std::uint32_t>;
+
+    struct Lane {
+        explicit Lane(std::size_t depth)
+            : blocks(depth), freeBlocks(depth * 2), batches(depth), freeBatches(depth * 2) {}
+        SpscRing<Block> blocks;
+        SpscRing<Block> freeBlocks;
+        SpscRing<Batch> batches;
+        SpscRing<Batch> freeBatches;
+    };
+
+    HashFunc h_;
+    PipelineConfig cfg_;
+    std::uint64_t sketchStalls_ = 0;
+
+    std::uint64_t readBlocks(std::FILE* in, std::vector<std::unique_ptr<Lane>>& lanes, bool& error) {
+        std::uint64_t total = 0;
+        Block carry;
+        std::size_t next = 0;
+
+        for (;;) {
+            Lane& lane = *lanes[next % lanes.size()];
+            Block buf;
+            if (!lane.freeBlocks.tryPop(buf)) buf.reserve(cfg_.blockSize + 256);
+
+            std::size_t keep = carry.size();
+            buf.assign(carry.begin(), carry.end());
+            buf.resize(keep + cfg_.blockSize);
+            std::size_t n;
+            {
+                SET5_TIME_SCOPE(readTimer, ReadCycles);
+                n = std::fread(buf.data() + keep, 1, cfg_.blockSize, in);
+            }
+            buf.resize(keep + n);
+            total += n;
+            SET5_COUNT(BytesRead, n);
+
+            if (n == 0) {
+                if (std::ferror(in)) error = true;
+                if (!buf.empty()) {
+                    buf.push_back('\n');
+                    lane.blocks.push(std::move(buf));
+                }
+                break;
+            }
+
+            const char* base = buf.data();
+            const void* nl = memrchr(base + keep, '\n', n);
+            if (!nl) {
+                carry.swap(buf);
+                continue;
+            }
+            std::size_t cut = static_cast<const char*>(nl) - base + 1;
+            carry.assign(buf.begin() + cut, buf.end());
+            buf.resize(cut);
+            lane.blocks.push(std::move(buf));
+            next++;
+        }
+
+        for (auto& lane : lanes) lane->blocks.close();
+        return total;
+    }
+
+    void hashBlocks(Lane& lane) {
+        Block b;
+        Batch out;
+        while (lane.blocks.pop(b)) {
+            if (!lane.freeBatches.tryPop(out)) out = Batch();
+            out.clear();
+
+            const char* p = b.data();
+            const char* end = p + b.size();
+            while (p < end) {
+                const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+                std::size_t len = nl - p;
+                if (len > 0 && p[len - 1] == '\r') len--;
+                SET5_TIME_SCOPE(hashTimer, HashCycles);
+                out.push_back(h_(std::string_view(p, len)));
+                p = nl + 1;
+            }
+
+            lane.batches.push(std::move(out));
+            lane.freeBlocks.tryPush(b);
+        }
+        lane.batches.close();
+    }
+
+    template <class T>
+    static QueueStats queueStats(std::string name, const SpscRing<T>& q) {
+        QueueStats s;
+        s.name = std::move(name);
+        s.capacity = q.capacity();
+        s.meanOccupancy = q.meanOccupancy();
+        s.maxOccupancy = q.maxOccupancy();
+        s.producerStalls = q.producerStalls();
+        s.consumerStalls = q.consumerStalls();
+        return s;
+    }
+};
@@ -0,0 +1,268 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Счётчики и таймеры горячего пути (хеш, HLL, точное множество, чтение).
+// По умолчанию выключены: макросы SET5_COUNT / SET5_TIME_SCOPE раскрываются в пустоту.
+// Включаются определением SET5_INSTRUMENT (опция CMake -DSET5_INSTRUMENT=ON).
+//
+// Каждый поток пишет только в свой блок счётчиков (relaxed load + store, без RMW),
+// snapshot() суммирует блоки живых потоков и итог завершившихся. При выходе потока
+// его счётчики переносятся в этот итог, а блок уходит в список свободных и достаётся
+// следующему потоку: блоков не больше, чем потоков одновременно.
+namespace instr {
+
+enum Counter : int {
+    HashCalls,
+    HashCycles,
+    HllAdds,
+    HllRegisterChanges,
+    HllFastSkips,
+    HllCycles,
+    ExactInserts,
+    ExactRehashes,
+    ExactCycles,
+    BytesRead,
+    ReadCycles,
+    NumCounters
+};
+
+inline const char* counterName(int c) {
+    static const char* names[NumCounters] = {
+        "hash_calls", "hash_cycles",
+        "hll_adds", "hll_register_changes", "hll_fast_skips", "hll_cycles",
+        "exact_inserts", "exact_rehashes", "exact_cycles",
+        "bytes_read", "read_cycles"
+    };
+    return names[c];
+}
+
+inline std::uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+struct ThreadCounters {
+    std::atomic<std::uint64_t> v[NumCounters] = {};
+};
+
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry r;
+        return r;
+    }
+
+    ThreadCounters& local() {
+        thread_local Slot slot(*this);
+        return *slot.tc;
+    }
+
+    // Свободные блоки нулевые, поэтому обходятся вместе с занятыми.
+    void forEach(const std::function<void(const ThreadCounters&)>& f) {
+        std::lock_guard<std::mutex> lock(mu_);
+        f(retired_);
+        for (const auto& tc : blocks_) f(*tc);
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mu_);
+        for (auto& x : retired_.v) x.store(0, std::memory_order_relaxed);
+        for (auto& tc : blocks_) {
+            for (auto& x : tc->v) x.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t blocks() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return blocks_.size();
+    }
+
+private:
+    // Блок потока на время его жизни; деструктор срабатывает при выходе потока.
+    struct Slot {
+        Registry& r;
+        ThreadCounters* tc;
+        explicit Slot(Registry& reg) : r(reg), tc(reg.attach()) {}
+        ~Slot() { r.detach(tc); }
+    };
+
+    std::mutex mu_;
+    std::vector<std::unique_ptr<ThreadCounters>> blocks_;
+    std::vector<ThreadCounters*> free_;
+    ThreadCounters retired_; // сумма завершившихся потоков
+
+    ThreadCounters* attach() {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!free_.empty()) {
+            ThreadCounters* tc = free_.back();
+            free_.pop_back();
+            return tc;
+        }
+        blocks_.push_back(std::make_unique<ThreadCounters>());
+        return blocks_.back().get();
+    }
+
+    // Вызывается из самого завершающегося потока, других писателей у блока нет.
+    void detach(ThreadCounters* tc) {
+        std::lock_guard<std::mutex> lock(mu_);
+        for (int i = 0; i < NumCounters; ++i) {
+            auto& sum = retired_.v[i];
+            sum.store(sum.load(std::memory_order_relaxed) + tc->v[i].load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+            tc->v[i].store(0, std::memory_order_relaxed);
+        }
+        free_.push_back(tc);
+    }
+};
+
+inline void add(Counter c, std::uint64_t n) {
+    auto& x = Registry::instance().local().v[c];
+    x.store(x.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Counter c) : c_(c), t0_(cycles()) {}
+    ~ScopedTimer() { add(c_, cycles() - t0_); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Counter c_;
+    std::uint64_t t0_;
+};
+
+struct Snapshot {
+    std::uint64_t v[NumCounters] = {};
+    std::chrono::steady_clock::time_point at;
+
+    std::uint64_t operator[](Counter c) const { return v[c]; }
+
+    Snapshot operator-(const Snapshot& prev) const {
+        Snapshot d;
+        for (int i = 0; i < NumCounters; ++i) d.v[i] = v[i] - prev.v[i];
+        d.at = at;
+        return d;
+    }
+};
+
+inline constexpr bool enabled() {
+#ifdef SET5_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+inline Snapshot snapshot() {
+    Snapshot s;
+    s.at = std::chrono::steady_clock::now();
+    Registry::instance().forEach([&](const ThreadCounters& tc) {
+        for (int i = 0; i < NumCounters; ++i) s.v[i] += tc.v[i].load(std::memory_order_relaxed);
+    });
+    return s;
+}
+
+inline void reset() { Registry::instance().clear(); }
+
+// Раз в interval вызывает callback с разницей к предыдущему снимку (и сам снимок).
+class PeriodicExporter {
+public:
+    using Callback = std::function<void(const Snapshot& delta, const Snapshot& total)>;
+
+    PeriodicExporter(std::chrono::milliseconds interval, Callback cb)
+        : interval_(interval), cb_(std::move(cb)), th_([this] { run(); }) {}
+
+    ~PeriodicExporter() {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        th_.join();
+    }
+
+    PeriodicExporter(const PeriodicExporter&) = delete;
+    PeriodicExporter& operator=(const PeriodicExporter&) = delete;
+
+private:
+    std::chrono::milliseconds interval_;
+    Callback cb_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread th_;
+
+    void run() {
+        Snapshot prev = snapshot();
+        std::unique_lock<std::mutex> lock(mu_);
+        while (!cv_.wait_for(lock, interval_, [this] { return stop_; })) {
+            Snapshot cur = snapshot();
+            cb_(cur - prev, cur);
+            prev = cur;
+        }
+    }
+};
+
+inline void printBreakdown(std::ostream& out, const Snapshot& s) {
+    if (!enabled()) {
+        out << "Instrumentation disabled (build with -DSET5_INSTRUMENT=ON)\n";
+        return;
+    }
+
+    struct Stage { const char* name; Counter calls; Counter cyc; };
+    const Stage stages[] = {
+        {"read",  BytesRead,    ReadCycles},
+        {"hash",  HashCalls,    HashCycles},
+        {"hll",   HllAdds,      HllCycles},
+        {"exact", ExactInserts, ExactCycles},
+    };
+
+    double total = 0.0;
+    for (const auto& st : stages) total += static_cast<double>(s[st.cyc]);
+
+    out << "stage   calls         Mcycles     cycles/call  share\n";
+    for (const auto& st : stages) {
+        double cyc = static_cast<double>(s[st.cyc]);
+        double calls = static_cast<double>(s[st.calls]);
+        out << std::left << std::setw(8) << st.name << std::right
+            << std::setw(12) << s[st.calls] << "  "
+            << std::setw(10) << std::fixed << std::setprecision(1) << cyc / 1e6 << "  "
+            << std::setw(12) << (calls > 0 ? cyc / calls : 0.0) << "  "
+            << std::setw(5) << (total > 0 ? 100.0 * cyc / total : 0.0) << "%\n";
+    }
+    out << std::defaultfloat;
+    out << "(read calls = bytes read)\nhll register changes: " << s[HllRegisterChanges]
+        << " (rate " << (s[HllAdds] ? static_cast<double>(s[HllRegisterChanges]) / s[HllAdds] : 0.0)
+        << "), fast-path skips: " << s[HllFastSkips]
+        << ", exact set rehashes: " << s[ExactRehashes] << "\n";
+}
+
+} // namespace instr
+
+#ifdef SET5_INSTRUMENT
+#define SET5_COUNT(counter, n) ::instr::add(::instr::counter, static_cast<std::uint64_t>(n))
+#define SET5_TIME_SCOPE(var, counter) ::instr::ScopedTimer var(::instr::counter)
+#else
+#define SET5_COUNT(counter, n) ((void)0)
+#define SET5_TIME_SCOPE(var, counter) ((void)0)
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "CardinalitySketch.hpp"
+
+// KMV (bottom-k): хранит k минимальных различных хешей.
+// Оценка (k - 1) / U_k, где U_k — k-й минимальный хеш, нормированный в (0, 1].
+// Если элементы добавлять через addKey, сохраняются и сами ключи —
+// это равномерная выборка из уникальных элементов потока.
+class KmvSketch final : public CardinalitySketch {
+public:
+    explicit KmvSketch(std::size_t k) : k_(k) {
+        if (k_ < 2) throw std::invalid_argument("KmvSketch: k must be >= 2");
+        hashes_.reserve(k_ + 1);
+    }
+
+    void reset() override {
+        hashes_.clear();
+        keys_.clear();
+        sorted_ = true;
+        filling_ = true;
+    }
+
+    void addHash(std::uint32_t x) override { offer(x); }
+
+    void addKey(const std::string& s, std::uint32_t x) {
+        if (offer(x)) keys_.emplace(x, s);
+    }
+
+    double estimate() const override {
+        normalize();
+        if (hashes_.size() < k_) return static_cast<double>(hashes_.size());
+        double uk = (static_cast<double>(hashes_.back()) + 1.0) / 4294967296.0;
+        return static_cast<double>(k_ - 1) / uk;
+    }
+
+    const std::vector<std::uint32_t>& sampledHashes() const {
+        normalize();
+        return hashes_;
+    }
+
+    std::vector<std::string> sampledKeys() const {
+        normalize();
+        std::vector<std::string> out;
+        out.reserve(keys_.size());
+        for (std::uint32_t x : hashes_) {
+            auto it = keys_.find(x);
+            if (it != keys_.end()) out.push_back(it->second);
+        }
+        return out;
+    }
+
+    std::size_t memoryBytes() const override {
+        std::size_t bytes = hashes_.capacity() * sizeof(std::uint32_t);
+        if (keys_.empty()) return bytes;
+        // узлы хеш-таблицы (ключ, строка, указатель на следующий узел) — только при addKey
+        return bytes + keys_.size() * (sizeof(std::pair<const std::uint32_t, std::string>) + sizeof(void*))
+                     + keys_.bucket_count() * sizeof(void*);
+    }
+
+    std::string name() const override { return "KMV(k=" + std::to_string(k_) + ")"; }
+
+    std::size_t k() const { return k_; }
+
+private:
+    std::size_t k_;
+    // k минимальных различных хешей по возрастанию: back() — k-й минимальный,
+    // повтор находится двоичным поиском. Первые k хешей (заполнение) дописываются
+    // в конец без поиска и сортируются разом: вставка в середину стоила бы O(k) каждая.
+    // estimate() логически константна, но может досортировать заполняемый массив.
+    mutable std::vector<std::uint32_t> hashes_;
+    mutable bool sorted_ = true;
+    bool filling_ = true;
+    std::unordered_map<std::uint32_t, std::string> keys_; // ключи выборки, только из addKey
+
+    // true, если x вошёл в выборку.
+    bool offer(std::uint32_t x) {
+        if (filling_) {
+            hashes_.push_back(x);
+            sorted_ = false;
+            if (hashes_.size() == k_) {
+                normalize();
+                filling_ = false;
+            }
+            return true;
+        }
+        if (hashes_.size() == k_ && x >= hashes_.back()) return false;
+        auto it = std::lower_bound(hashes_.begin(), hashes_.end(), x);
+        if (it != hashes_.end() && *it == x) return false;
+        hashes_.insert(it, x);
+        if (hashes_.size() > k_) {
+            if (!keys_.empty()) keys_.erase(hashes_.back());
+            hashes_.pop_back();
+        }
+        return true;
+    }
+
+    void normalize() const {
+        if (sorted_) return;
+        std::sort(hashes_.begin(), hashes_.end());
+        hashes_.erase(std::unique(hashes_.begin(), hashes_.end()), hashes_.end());
+        sorted_ = true;
+    }
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "CardinalitySketch.hpp"
+
+// Linear counting: битовая карта из m = 2^B бит, оценка m * ln(m / V),
+// где V — число нулевых бит. Точна для множеств заметно меньше m.
+class LinearCounting final : public CardinalitySketch {
+public:
+    explicit LinearCounting(int B)
+        : B_(B), m_(1u << B), bits_((m_ + 63) / 64, 0), zeros_(m_) {
+        if (B_ <= 0 || B_ >= 31) throw std::invalid_argument("B must be in [1..30]");
+    }
+
+    void reset() override {
+        std::fill(bits_.begin(), bits_.end(), 0);
+        zeros_ = m_;
+    }
+
+    void addHash(std::uint32_t x) override {
+        std::uint32_t idx = x >> (32 - B_);
+        std::uint64_t& word = bits_[idx >> 6];
+        std::uint64_t mask = 1ULL << (idx & 63);
+        if (!(word & mask)) {
+            word |= mask;
+            zeros_--;
+        }
+    }
+
+    double estimate() const override {
+        double m = static_cast<double>(m_);
+        // карта заполнена: дальше оценка не растёт, возвращаем верхнюю границу
+        if (zeros_ == 0) return m * std::log(m);
+        return m * std::log(m / static_cast<double>(zeros_));
+    }
+
+    std::size_t memoryBytes() const override { return bits_.size() * sizeof(std::uint64_t); }
+    std::string name() const override { return "LinearCounting(B=" + std::to_string(B_) + ")"; }
+
+    int B() const { return B_; }
+    std::uint32_t m() const { return m_; }
+
+private:
+    int B_;
+    std::uint32_t m_;
+    std::vector<std::uint64_t> bits_;
+    std::uint32_t zeros_;
+};
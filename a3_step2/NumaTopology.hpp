@@ -0,0 +1,115 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// NUMA-топология из sysfs (/sys/devices/system/node) без libnuma. На машинах без
+// этого каталога (или в контейнере, где он скрыт) считается, что узел один и на нём все CPU.
+// Вне Linux узел всегда один, привязка потоков не делается.
+namespace topology {
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11}
+inline std::vector<int> parseCpuList(const std::string& s) {
+    std::vector<int> cpus;
+    std::size_t pos = 0;
+    while (pos < s.size()) {
+        std::size_t end = s.find(',', pos);
+        if (end == std::string::npos) end = s.size();
+        std::string part = s.substr(pos, end - pos);
+        std::size_t dash = part.find('-');
+        try {
+            if (dash == std::string::npos) {
+                if (!part.empty() && part != "\n") cpus.push_back(std::stoi(part));
+            } else {
+                int a = std::stoi(part.substr(0, dash));
+                int b = std::stoi(part.substr(dash + 1));
+                for (int c = a; c <= b; ++c) cpus.push_back(c);
+            }
+        } catch (const std::exception&) {
+            return {};
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+inline std::vector<int> nodeCpus(int node) {
+    std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string line;
+    if (!in || !std::getline(in, line)) return {};
+    return parseCpuList(line);
+}
+
+// Узлы считаются подряд с node0, пока есть cpulist.
+inline int nodeCount() {
+    static const int n = [] {
+        int k = 0;
+        while (!nodeCpus(k).empty()) k++;
+        return k > 0 ? k : 1;
+    }();
+    return n;
+}
+
+inline int nodeOfCpu(int cpu) {
+    for (int n = 0; n < nodeCount(); ++n) {
+        for (int c : nodeCpus(n)) {
+            if (c == cpu) return n;
+        }
+    }
+    return 0;
+}
+
+// Узел, на котором сейчас выполняется поток.
+inline int currentNode() {
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : nodeOfCpu(cpu);
+#else
+    return 0;
+#endif
+}
+
+// Привязывает текущий поток к CPU узла. false — узел неизвестен или affinity запрещена.
+inline bool pinCurrentThreadToNode(int node) {
+#ifdef __linux__
+    std::vector<int> cpus = nodeCpus(node);
+    if (cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c < CPU_SETSIZE) CPU_SET(c, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+// Восстанавливает affinity потока при выходе из области видимости.
+class AffinityGuard {
+public:
+#ifdef __linux__
+    AffinityGuard() { saved_ = pthread_getaffinity_np(pthread_self(), sizeof(mask_), &mask_) == 0; }
+    ~AffinityGuard() {
+        if (saved_) pthread_setaffinity_np(pthread_self(), sizeof(mask_), &mask_);
+    }
+#else
+    AffinityGuard() = default;
+#endif
+    AffinityGuard(const AffinityGuard&) = delete;
+    AffinityGuard& operator=(const AffinityGuard&) = delete;
+
+#ifdef __linux__
+private:
+    cpu_set_t mask_;
+    bool saved_ = false;
+#endif
+};
+
+} // namespace topology
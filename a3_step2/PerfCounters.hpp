@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Аппаратный счётчик через perf_event_open для текущего потока, только user-space.
+// Если ядро или контейнер не дают счётчик (perf_event_paranoid, seccomp, нет PMU в ВМ),
+// available() == false, а read() возвращает 0 — вызывающий решает, что печатать.
+class PerfCounter {
+public:
+    PerfCounter(std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~PerfCounter() {
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    // Промахи dTLB на чтение.
+    static PerfCounter dtlbReadMisses() {
+        return PerfCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    }
+
+    bool available() const { return fd_ >= 0; }
+
+    void start() {
+        if (fd_ < 0) return;
+        ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    void stop() {
+        if (fd_ >= 0) ::ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    std::uint64_t read() const {
+        std::uint64_t v = 0;
+        if (fd_ < 0 || ::read(fd_, &v, sizeof(v)) != static_cast<ssize_t>(sizeof(v))) return 0;
+        return v;
+    }
+
+private:
+    int fd_ = -1;
+};
@@ -6,6 +6,8 @@
 #include <fstream>
 #include <stdexcept>
 
+#include "Instrumentation.hpp"
+
 class RandomStreamGen {
 public:
 struct Config {
@@ -77,9 +79,11 @@ struct Config {
         std::ifstream in(path);
         if (!in) throw std::runtime_error("Cannot open file for reading: " + path);
 
+        SET5_TIME_SCOPE(readTimer, ReadCycles);
         std::vector<std::string> stream;
         std::string line;
         while (std::getline(in, line)) {
+            SET5_COUNT(BytesRead, line.size() + 1);
             if (!line.empty() && line.back() == '\r') line.pop_back();
             stream.push_back(line);
         }
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// Источник памяти под регистры скетча. Реализация с huge pages и узлами NUMA —
+// RegisterArena (RegisterMemory.hpp, только Linux); здесь только интерфейс, без
+// системных заголовков, чтобы HyperLogLog.hpp собирался где угодно.
+class RegisterSource {
+public:
+    virtual ~RegisterSource() = default;
+    virtual void* allocate(std::size_t n) = 0;
+    virtual void deallocate(void* p, std::size_t n) = 0;
+};
+
+// Аллокатор с состоянием для std::vector регистров. Без источника — обычный new/delete,
+// поэтому HyperLogLog по умолчанию ведёт себя как раньше. Копия контейнера
+// остаётся в том же источнике.
+template <class T>
+class RegisterAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    RegisterAllocator() noexcept = default;
+    explicit RegisterAllocator(RegisterSource* source) noexcept : source_(source) {}
+    template <class U>
+    RegisterAllocator(const RegisterAllocator<U>& other) noexcept : source_(other.source()) {}
+
+    T* allocate(std::size_t n) {
+        if (!source_) return std::allocator<T>().allocate(n);
+        return static_cast<T*>(source_->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (!source_) std::allocator<T>().deallocate(p, n);
+        else source_->deallocate(p, n * sizeof(T));
+    }
+
+    RegisterSource* source() const noexcept { return source_; }
+
+    template <class U>
+    bool operator==(const RegisterAllocator<U>& o) const noexcept { return source_ == o.source(); }
+    template <class U>
+    bool operator!=(const RegisterAllocator<U>& o) const noexcept { return source_ != o.source(); }
+
+private:
+    RegisterSource* source_ = nullptr;
+};
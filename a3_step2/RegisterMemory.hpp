@@ -0,0 +1,179 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "NumaTopology.hpp"
+#include "RegisterAllocator.hpp"
+
+// Память под регистры большого числа скетчей. При миллионах HyperLogLog и случайных
+// regs_[idx] обновления упираются в TLB: каждый скетч на своей 4 KiB странице.
+// RegisterArena нарезает массивы регистров из кусков по 2 MiB, выровненных под
+// huge page, и (по желанию) привязывает их к узлу NUMA.
+//
+//   HugePages::None        — обычные страницы (но массивы всё равно плотно упакованы)
+//   HugePages::Transparent — madvise(MADV_HUGEPAGE), THP в режиме madvise или always
+//   HugePages::Explicit    — MAP_HUGETLB из пула hugetlbfs; если пул пуст — как Transparent
+//
+// Вне Linux куски берутся из кучи с выравниванием 2 MiB, режим страниц и узел игнорируются.
+//
+// Освобождённые массивы уходят в списки свободных по размеру (m = 2^B, классы — степени
+// двойки) и переиспользуются; куски возвращаются ОС только в деструкторе арены,
+// поэтому арена должна пережить все свои скетчи.
+enum class HugePages { None, Transparent, Explicit };
+
+struct ArenaStats {
+    std::size_t chunks = 0;
+    std::size_t bytesMapped = 0;
+    std::size_t hugetlbChunks = 0;   // реально получены из пула hugetlbfs
+    std::size_t thpChunks = 0;       // помечены MADV_HUGEPAGE
+    std::size_t boundChunks = 0;     // mbind к узлу удался
+    std::size_t bytesInUse = 0;
+};
+
+class RegisterArena final : public RegisterSource {
+public:
+    static constexpr std::size_t kHugePage = std::size_t(2) << 20;
+    static constexpr std::size_t kMinBlock = 64; // линия кэша
+
+    explicit RegisterArena(HugePages pages = HugePages::Transparent, int node = -1,
+                           std::size_t chunkBytes = kHugePage)
+        : pages_(pages), node_(node), chunkBytes_(roundUp(chunkBytes, kHugePage)) {}
+
+    ~RegisterArena() override {
+        for (const auto& c : chunks_) {
+#ifdef __linux__
+            ::munmap(c.base, c.size);
+#else
+            ::operator delete(c.base, std::align_val_t(kHugePage));
+#endif
+        }
+    }
+
+    RegisterArena(const RegisterArena&) = delete;
+    RegisterArena& operator=(const RegisterArena&) = delete;
+
+    void* allocate(std::size_t n) override {
+        const int cls = sizeClass(n);
+        const std::size_t size = std::size_t(1) << cls;
+        std::lock_guard<std::mutex> lk(mu_);
+        stats_.bytesInUse += size;
+        if (!free_[cls].empty()) {
+            void* p = free_[cls].back();
+            free_[cls].pop_back();
+            return p;
+        }
+        if (size > chunkBytes_) return mapChunk(roundUp(size, kHugePage));
+        if (cur_ == nullptr || static_cast<std::size_t>(end_ - cur_) < size) {
+            cur_ = static_cast<char*>(mapChunk(chunkBytes_));
+            end_ = cur_ + chunkBytes_;
+        }
+        void* p = cur_;
+        cur_ += size;
+        return p;
+    }
+
+    void deallocate(void* p, std::size_t n) override {
+        if (!p) return;
+        const int cls = sizeClass(n);
+        std::lock_guard<std::mutex> lk(mu_);
+        stats_.bytesInUse -= std::size_t(1) << cls;
+        free_[cls].push_back(p);
+    }
+
+    HugePages pages() const { return pages_; }
+    int node() const { return node_; }
+
+    ArenaStats stats() const {
+        std::lock_guard<std::mutex> lk(mu_);
+        return stats_;
+    }
+
+private:
+    struct Chunk {
+        void* base;
+        std::size_t size;
+    };
+
+    HugePages pages_;
+    int node_;
+    std::size_t chunkBytes_;
+    mutable std::mutex mu_;
+    std::vector<Chunk> chunks_;
+    std::vector<void*> free_[64];
+    char* cur_ = nullptr;
+    char* end_ = nullptr;
+    ArenaStats stats_;
+
+    static std::size_t roundUp(std::size_t n, std::size_t to) { return (n + to - 1) / to * to; }
+
+    static int sizeClass(std::size_t n) {
+        if (n <= kMinBlock) return 6;
+        return 64 - __builtin_clzll(n - 1);
+    }
+
+    // Кусок size байт (кратно 2 MiB), выровненный на 2 MiB.
+    void* mapChunk(std::size_t size) {
+#ifdef __linux__
+        void* p = MAP_FAILED;
+        bool hugetlb = false;
+        if (pages_ == HugePages::Explicit) {
+            p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            hugetlb = p != MAP_FAILED;
+        }
+        if (p == MAP_FAILED) {
+            // запас в 2 MiB на выравнивание, лишнее по краям отдаётся обратно
+            std::size_t span = size + kHugePage;
+            void* raw = ::mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) throw std::bad_alloc();
+            std::uintptr_t a = reinterpret_cast<std::uintptr_t>(raw);
+            std::uintptr_t aligned = roundUp(a, kHugePage);
+            if (aligned > a) ::munmap(raw, aligned - a);
+            std::size_t tail = a + span - (aligned + size);
+            if (tail) ::munmap(reinterpret_cast<void*>(aligned + size), tail);
+            p = reinterpret_cast<void*>(aligned);
+            if (pages_ != HugePages::None && ::madvise(p, size, MADV_HUGEPAGE) == 0) stats_.thpChunks++;
+        }
+        if (hugetlb) stats_.hugetlbChunks++;
+
+        // политика «предпочтительный узел»: если на узле нет памяти, ядро возьмёт с другого
+        if (node_ >= 0 && node_ < 64) {
+            unsigned long mask = 1UL << node_;
+            if (::syscall(SYS_mbind, p, size, MPOL_PREFERRED, &mask, 64, 0) == 0) stats_.boundChunks++;
+        }
+#else
+        void* p = ::operator new(size, std::align_val_t(kHugePage));
+#endif
+
+        chunks_.push_back(Chunk{p, size});
+        stats_.chunks++;
+        stats_.bytesMapped += size;
+        return p;
+    }
+};
+
+// По арене на узел NUMA; local() выбирает узел вызывающего потока.
+class NumaArenas {
+public:
+    explicit NumaArenas(HugePages pages = HugePages::Transparent) {
+        for (int n = 0; n < topology::nodeCount(); ++n) arenas_.emplace_back(new RegisterArena(pages, n));
+    }
+
+    int nodes() const { return static_cast<int>(arenas_.size()); }
+    RegisterArena& node(int n) { return *arenas_.at(static_cast<std::size_t>(n)); }
+    RegisterArena& local() { return node(topology::currentNode() % nodes()); }
+
+private:
+    std::vector<std::unique_ptr<RegisterArena>> arenas_;
+};
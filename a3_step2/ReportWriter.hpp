@@ -0,0 +1,338 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Быстрый вывод отчётов: CSV через буфер и std::to_chars, плюс колоночный
+// бинарный файл-спутник (<path>.col), который графические утилиты читают без разбора текста.
+//
+// Формат .col (little-endian):
+//   "SET5COL2" | u32 число колонок | u64 число строк (дописывается при закрытии)
+//   по колонке: u16 длина имени, имя, u8 тип (1 = f64, 2 = строка, 3 = u64)
+//   затем блоки до kColumnarChunkRows строк: u32 строк в блоке, и по каждой колонке
+//   её значения блока: f64[n], u64[n] или n раз (u32 длина, байты).
+// Блоки пишутся по мере поступления строк, поэтому память писателя не растёт с отчётом.
+
+// Число с фиксированной точностью, запятая вместо точки, без хвостовых нулей
+// ("12,5", "3"). Возвращает длину; out должен вмещать 350 + precision байт.
+inline std::size_t formatExcelDouble(char* out, std::size_t cap, double x, int precision) {
+    auto res = std::to_chars(out, out + cap, x, std::chars_format::fixed, precision);
+    if (res.ec != std::errc()) throw std::runtime_error("formatExcelDouble: buffer too small");
+    std::size_t n = res.ptr - out;
+
+    char* dot = static_cast<char*>(std::memchr(out, '.', n));
+    if (dot) {
+        *dot = ',';
+        while (n > 1 && out[n - 1] == '0') n--;
+        if (out[n - 1] == ',') n--;
+    }
+    return n;
+}
+
+constexpr std::uint32_t kColumnarChunkRows = 1 << 16;
+
+// Колоночный файл .col без CSV: серии, которые в тексте заняли бы в разы больше места
+// (траектории по каждому элементу и т.п.). Держит в памяти только текущий блок.
+// Тип колонки задаётся первым значением; заголовок пишется вместе с первым блоком.
+class ColumnarWriter {
+public:
+    ColumnarWriter(const std::string& path, std::vector<std::string> names)
+        : path_(path), names_(std::move(names)), cols_(names_.size()) {
+        if (names_.empty()) throw std::invalid_argument("ColumnarWriter: no columns");
+        out_ = std::fopen(path.c_str(), "wb");
+        if (!out_) throw std::runtime_error("Cannot open file for writing: " + path);
+    }
+
+    ~ColumnarWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    ColumnarWriter(const ColumnarWriter&) = delete;
+    ColumnarWriter& operator=(const ColumnarWriter&) = delete;
+
+    void number(std::size_t col, double v) {
+        Column& c = column(col, kF64);
+        c.num.push_back(v);
+    }
+
+    void integer(std::size_t col, std::uint64_t v) {
+        Column& c = column(col, kU64);
+        c.u64.push_back(v);
+    }
+
+    void text(std::size_t col, std::string_view s) {
+        Column& c = column(col, kString);
+        std::uint32_t len = static_cast<std::uint32_t>(s.size());
+        c.bytes.append(reinterpret_cast<const char*>(&len), 4);
+        c.bytes.append(s.data(), s.size());
+        c.count++;
+    }
+
+    void endRow() {
+        rows_++;
+        if (++chunkRows_ == kColumnarChunkRows) flushChunk();
+    }
+
+    std::uint64_t rows() const { return rows_; }
+
+    void close() {
+        if (!out_) return;
+        flushChunk();
+        if (!headerDone_) writeHeader();
+        // число строк — в заголовок, на место нуля
+        bool ok = std::fseek(out_, 12, SEEK_SET) == 0 && std::fwrite(&rows_, 8, 1, out_) == 1;
+        ok = std::fclose(out_) == 0 && ok;
+        out_ = nullptr;
+        if (!ok) throw std::runtime_error("ColumnarWriter: write failed: " + path_);
+    }
+
+private:
+    enum : std::uint8_t { kF64 = 1, kString = 2, kU64 = 3 };
+
+    struct Column {
+        std::uint8_t type = 0;
+        std::vector<double> num;
+        std::vector<std::uint64_t> u64;
+        std::string bytes; // строки блока уже в формате файла
+        std::uint32_t count = 0;
+    };
+
+    std::string path_;
+    std::vector<std::string> names_;
+    std::vector<Column> cols_;
+    std::FILE* out_ = nullptr;
+    std::uint64_t rows_ = 0;
+    std::uint32_t chunkRows_ = 0;
+    bool headerDone_ = false;
+
+    Column& column(std::size_t col, std::uint8_t type) {
+        if (col >= cols_.size()) throw std::out_of_range("ColumnarWriter: no such column");
+        Column& c = cols_[col];
+        if (c.type == 0) {
+            if (headerDone_) throw std::logic_error("ColumnarWriter: column type changed");
+            c.type = type;
+        }
+        if (c.type != type) throw std::logic_error("ColumnarWriter: column type changed");
+        return c;
+    }
+
+    void raw(const void* p, std::size_t n) {
+        if (n && std::fwrite(p, 1, n, out_) != n) throw std::runtime_error("ColumnarWriter: write failed: " + path_);
+    }
+
+    void writeHeader() {
+        std::uint32_t ncols = static_cast<std::uint32_t>(names_.size());
+        std::uint64_t rows = 0;
+        raw("SET5COL2", 8);
+        raw(&ncols, 4);
+        raw(&rows, 8);
+        for (std::size_t i = 0; i < names_.size(); ++i) {
+            if (cols_[i].type == 0) cols_[i].type = kF64;
+            std::uint16_t len = static_cast<std::uint16_t>(names_[i].size());
+            raw(&len, 2);
+            raw(names_[i].data(), len);
+            raw(&cols_[i].type, 1);
+        }
+        headerDone_ = true;
+    }
+
+    void flushChunk() {
+        if (chunkRows_ == 0) return;
+        for (const auto& c : cols_) {
+            std::size_t n = c.type == kString ? c.count : c.type == kU64 ? c.u64.size() : c.num.size();
+            if (n != chunkRows_) throw std::logic_error("ColumnarWriter: column length differs from row count");
+        }
+        if (!headerDone_) writeHeader();
+        raw(&chunkRows_, 4);
+        for (auto& c : cols_) {
+            if (c.type == kString) {
+                raw(c.bytes.data(), c.bytes.size());
+                c.bytes.clear();
+                c.count = 0;
+            } else if (c.type == kU64) {
+                raw(c.u64.data(), c.u64.size() * sizeof(std::uint64_t));
+                c.u64.clear();
+            } else {
+                raw(c.num.data(), c.num.size() * sizeof(double));
+                c.num.clear();
+            }
+        }
+        chunkRows_ = 0;
+    }
+};
+
+class ReportWriter {
+public:
+    ReportWriter(const std::string& path, std::vector<std::string> columns,
+                 bool sidecar = false, char sep = ';')
+        : path_(path), names_(std::move(columns)), sep_(sep) {
+        if (names_.empty()) throw std::invalid_argument("ReportWriter: no columns");
+        out_ = std::fopen(path.c_str(), "wb");
+        if (!out_) throw std::runtime_error("Cannot open file for writing: " + path);
+        buf_.reserve(kBufSize + 512);
+        if (sidecar) cols_.reset(new ColumnarWriter(path + ".col", names_));
+
+        for (std::size_t i = 0; i < names_.size(); ++i) {
+            if (i) buf_.push_back(sep_);
+            buf_.append(names_[i]);
+        }
+        buf_.push_back('\n');
+    }
+
+    ~ReportWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+
+    ReportWriter& field(std::uint64_t v) {
+        char tmp[24];
+        auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        put(tmp, res.ptr - tmp);
+        if (cols_) cols_->integer(col_ - 1, v);
+        return *this;
+    }
+
+    ReportWriter& field(double v, int precision) {
+        char tmp[400];
+        put(tmp, formatExcelDouble(tmp, sizeof(tmp), v, precision));
+        if (cols_) cols_->number(col_ - 1, v);
+        return *this;
+    }
+
+    ReportWriter& field(std::string_view s) {
+        put(s.data(), s.size());
+        if (cols_) cols_->text(col_ - 1, s);
+        return *this;
+    }
+
+    void endRow() {
+        if (col_ != names_.size()) throw std::logic_error("ReportWriter: row has wrong number of fields");
+        buf_.push_back('\n');
+        col_ = 0;
+        if (cols_) cols_->endRow();
+        if (buf_.size() >= kBufSize) flushBuffer();
+    }
+
+    void close() {
+        if (!out_) return;
+        flushBuffer();
+        int rc = std::fclose(out_);
+        out_ = nullptr;
+        if (rc != 0) throw std::runtime_error("ReportWriter: write failed: " + path_);
+        if (cols_) cols_->close(); // после CSV: спутник не старше CSV
+    }
+
+private:
+    static constexpr std::size_t kBufSize = 1 << 16;
+
+    std::string path_;
+    std::vector<std::string> names_;
+    char sep_;
+    std::FILE* out_ = nullptr;
+    std::string buf_;
+    std::size_t col_ = 0;
+    std::unique_ptr<ColumnarWriter> cols_;
+
+    void put(const char* p, std::size_t n) {
+        if (col_ >= names_.size()) throw std::logic_error("ReportWriter: too many fields in row");
+        if (col_++) buf_.push_back(sep_);
+        buf_.append(p, n);
+    }
+
+    void flushBuffer() {
+        if (buf_.empty()) return;
+        if (std::fwrite(buf_.data(), 1, buf_.size(), out_) != buf_.size()) {
+            throw std::runtime_error("ReportWriter: write failed: " + path_);
+        }
+        buf_.clear();
+    }
+};
+
+// Числовые колонки файла .col (u64 приводятся к double); строковые колонки пропускаются.
+struct ColumnarData {
+    std::uint64_t rows = 0;
+    std::vector<std::string> names;
+    std::vector<std::vector<double>> columns;
+
+    const std::vector<double>& column(const std::string& name) const {
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            if (names[i] == name) return columns[i];
+        }
+        throw std::runtime_error("ColumnarData: no numeric column " + name);
+    }
+};
+
+inline ColumnarData readColumnar(const std::string& path) {
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> f(std::fopen(path.c_str(), "rb"), &std::fclose);
+    if (!f) throw std::runtime_error("Cannot open: " + path);
+    auto raw = [&](void* p, std::size_t n) {
+        if (n && std::fread(p, 1, n, f.get()) != n) throw std::runtime_error("Truncated columnar file: " + path);
+    };
+
+    char magic[8];
+    raw(magic, 8);
+    if (std::memcmp(magic, "SET5COL2", 8) != 0) throw std::runtime_error("Not a columnar file: " + path);
+
+    std::uint32_t ncols;
+    ColumnarData d;
+    raw(&ncols, 4);
+    raw(&d.rows, 8);
+
+    std::vector<std::string> names(ncols);
+    std::vector<std::uint8_t> types(ncols);
+    std::vector<std::vector<double>> cols(ncols);
+    for (std::uint32_t i = 0; i < ncols; ++i) {
+        std::uint16_t len;
+        raw(&len, 2);
+        names[i].resize(len);
+        raw(&names[i][0], len);
+        raw(&types[i], 1);
+        if (types[i] != 2) cols[i].reserve(d.rows);
+    }
+
+    std::vector<std::uint64_t> block; // u64-колонка блока до перевода в double
+    std::uint64_t seen = 0;
+    while (seen < d.rows) {
+        std::uint32_t n;
+        raw(&n, 4);
+        if (n == 0 || n > d.rows - seen) throw std::runtime_error("Bad columnar block: " + path);
+        for (std::uint32_t i = 0; i < ncols; ++i) {
+            if (types[i] == 1) {
+                std::size_t at = cols[i].size();
+                cols[i].resize(at + n);
+                raw(cols[i].data() + at, n * sizeof(double));
+            } else if (types[i] == 3) {
+                block.resize(n);
+                raw(block.data(), n * sizeof(std::uint64_t));
+                cols[i].insert(cols[i].end(), block.begin(), block.end());
+            } else {
+                for (std::uint32_t r = 0; r < n; ++r) {
+                    std::uint32_t len;
+                    raw(&len, 4);
+                    if (std::fseek(f.get(), len, SEEK_CUR) != 0) throw std::runtime_error("Truncated columnar file: " + path);
+                }
+            }
+        }
+        seen += n;
+    }
+    for (std::uint32_t i = 0; i < ncols; ++i) {
+        if (types[i] == 2) continue;
+        d.names.push_back(names[i]);
+        d.columns.push_back(std::move(cols[i]));
+    }
+    return d;
+}
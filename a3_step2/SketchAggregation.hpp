@@ -0,0 +1,333 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "HyperLogLog.hpp"
+
+// Протокол агрегатора скетчей (hll_aggd) и клиентская часть.
+//
+// Кадр: u32 длина тела (LE) | u8 тип | тело.
+//   Full   : имя, B, seed, m байт регистров
+//   Delta  : имя, B, seed, u32 count, count пар (varint шаг индекса, u8 значение)
+//   Query  : имя                        -> Estimate: u8 найдено, f64 оценка
+//   Error  : строка (ответ сервера на некорректное обновление или запрос)
+// Имя — u16 длина + байты. Сервер сливает регистры поэлементным max,
+// поэтому порядок и повторы обновлений не важны.
+namespace agg {
+
+enum MsgType : std::uint8_t {
+    Full = 1,
+    Delta = 2,
+    Query = 3,
+    Estimate = 4,
+    Error = 5,
+};
+
+inline std::size_t varintBytes(std::uint32_t v) {
+    std::size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+// Наибольшая длина кадра (тип + тело) с обновлением скетча точности до maxB: имя
+// до 0xFFFF байт, B, seed и либо m регистров, либо count и до m пар (varint + значение).
+inline std::uint32_t maxUpdateFrame(int maxB) {
+    const std::uint32_t m = 1u << maxB;
+    const std::size_t header = 1 + 2 + 0xFFFF + 1 + 8;
+    const std::size_t delta = 4 + static_cast<std::size_t>(m) * (varintBytes(m - 1) + 1);
+    return static_cast<std::uint32_t>(std::min<std::size_t>(header + std::max<std::size_t>(m, delta), UINT32_MAX));
+}
+
+// Ответы сервера: Estimate или Error со строкой.
+constexpr std::uint32_t kMaxReplyFrame = 1 + 2 + 0xFFFF;
+
+class Writer {
+public:
+    void u8(std::uint8_t v) { buf_.push_back(static_cast<char>(v)); }
+    void u16(std::uint16_t v) { raw(&v, 2); }
+    void u32(std::uint32_t v) { raw(&v, 4); }
+    void u64(std::uint64_t v) { raw(&v, 8); }
+    void f64(double v) { raw(&v, 8); }
+    void bytes(const void* p, std::size_t n) { raw(p, n); }
+
+    void str(const std::string& s) {
+        if (s.size() > 0xFFFF) throw std::invalid_argument("agg: name too long");
+        u16(static_cast<std::uint16_t>(s.size()));
+        raw(s.data(), s.size());
+    }
+
+    void varint(std::uint32_t v) {
+        while (v >= 0x80) {
+            u8(static_cast<std::uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        u8(static_cast<std::uint8_t>(v));
+    }
+
+    const std::string& data() const { return buf_; }
+
+    // Кадр целиком: длина + тип + тело.
+    std::string frame(MsgType type) const {
+        std::string out;
+        std::uint32_t len = static_cast<std::uint32_t>(buf_.size() + 1);
+        out.append(reinterpret_cast<const char*>(&len), 4);
+        out.push_back(static_cast<char>(type));
+        out += buf_;
+        return out;
+    }
+
+private:
+    std::string buf_;
+
+    // Порядок байт — little-endian (x86/ARM); для big-endian хостов понадобится bswap.
+    void raw(const void* p, std::size_t n) { buf_.append(static_cast<const char*>(p), n); }
+};
+
+class Reader {
+public:
+    Reader(const char* p, std::size_t n) : p_(p), end_(p + n) {}
+
+    std::uint8_t u8() { std::uint8_t v; raw(&v, 1); return v; }
+    std::uint16_t u16() { std::uint16_t v; raw(&v, 2); return v; }
+    std::uint32_t u32() { std::uint32_t v; raw(&v, 4); return v; }
+    std::uint64_t u64() { std::uint64_t v; raw(&v, 8); return v; }
+    double f64() { double v; raw(&v, 8); return v; }
+
+    const char* bytes(std::size_t n) {
+        need(n);
+        const char* p = p_;
+        p_ += n;
+        return p;
+    }
+
+    std::string str() {
+        std::size_t n = u16();
+        return std::string(bytes(n), n);
+    }
+
+    std::uint32_t varint() {
+        std::uint32_t v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            std::uint8_t b = u8();
+            v |= static_cast<std::uint32_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        throw std::runtime_error("agg: bad varint");
+    }
+
+    std::size_t left() const { return end_ - p_; }
+
+private:
+    const char* p_;
+    const char* end_;
+
+    void need(std::size_t n) const {
+        if (static_cast<std::size_t>(end_ - p_) < n) throw std::runtime_error("agg: truncated message");
+    }
+    void raw(void* dst, std::size_t n) { std::memcpy(dst, bytes(n), n); }
+};
+
+// Изменения регистров с последней отправки. Память — копия m регистров,
+// размер дельты не больше m пар и не зависит от объёма потока.
+class DeltaTracker {
+public:
+    explicit DeltaTracker(int B) : B_(B), sent_(1u << B, 0) {}
+
+    // Собирает кадр Delta (или пустую строку, если менять нечего).
+    std::string collect(const std::string& name, const HyperLogLog& hll, std::uint64_t seed) {
+        if (hll.B() != B_) throw std::invalid_argument("DeltaTracker: B mismatch");
+        const std::uint8_t* regs = hll.registers();
+
+        Writer body;
+        std::uint32_t count = 0;
+        std::uint32_t prev = 0;
+        Writer pairs;
+        for (std::uint32_t i = 0; i < sent_.size(); ++i) {
+            if (regs[i] > sent_[i]) {
+                pairs.varint(i - prev);
+                pairs.u8(regs[i]);
+                sent_[i] = regs[i];
+                prev = i;
+                count++;
+            }
+        }
+        if (count == 0) return std::string();
+
+        body.str(name);
+        body.u8(static_cast<std::uint8_t>(B_));
+        body.u64(seed);
+        body.u32(count);
+        body.bytes(pairs.data().data(), pairs.data().size());
+        return body.frame(Delta);
+    }
+
+private:
+    int B_;
+    std::vector<std::uint8_t> sent_;
+};
+
+inline std::string fullFrame(const std::string& name, const HyperLogLog& hll, std::uint64_t seed) {
+    Writer w;
+    w.str(name);
+    w.u8(static_cast<std::uint8_t>(hll.B()));
+    w.u64(seed);
+    w.bytes(hll.registers(), hll.m());
+    return w.frame(Full);
+}
+
+inline std::string queryFrame(const std::string& name) {
+    Writer w;
+    w.str(name);
+    return w.frame(Query);
+}
+
+// ---- сокеты ----
+
+struct Endpoint {
+    std::string unixPath; // если пусто — TCP на 127.0.0.1:port
+    std::uint16_t port = 0;
+};
+
+inline Endpoint parseEndpoint(const std::string& kind, const std::string& value) {
+    Endpoint ep;
+    if (kind == "--unix") ep.unixPath = value;
+    else if (kind == "--tcp") ep.port = static_cast<std::uint16_t>(std::stoi(value));
+    else throw std::invalid_argument("expected --unix PATH or --tcp PORT");
+    return ep;
+}
+
+inline void sysCheck(bool ok, const char* what) {
+    if (!ok) throw std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+}
+
+inline int openSocket(const Endpoint& ep, bool listening) {
+    int fd;
+    if (!ep.unixPath.empty()) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (ep.unixPath.size() >= sizeof(addr.sun_path)) throw std::invalid_argument("unix socket path too long");
+        std::strcpy(addr.sun_path, ep.unixPath.c_str());
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sysCheck(fd >= 0, "socket");
+        if (listening) {
+            ::unlink(ep.unixPath.c_str());
+            sysCheck(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0, "bind");
+        } else {
+            sysCheck(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0, "connect");
+        }
+    } else {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(ep.port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sysCheck(fd >= 0, "socket");
+        int one = 1;
+        if (listening) {
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            sysCheck(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0, "bind");
+        } else {
+            sysCheck(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0, "connect");
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+    }
+    if (listening) sysCheck(::listen(fd, 64) == 0, "listen");
+    return fd;
+}
+
+inline void writeAll(int fd, const std::string& data) {
+    std::size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = ::send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        sysCheck(n > 0, "send");
+        off += static_cast<std::size_t>(n);
+    }
+}
+
+inline void readAll(int fd, char* dst, std::size_t n) {
+    while (n > 0) {
+        ssize_t r = ::recv(fd, dst, n, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r == 0) throw std::runtime_error("connection closed");
+        sysCheck(r > 0, "recv");
+        dst += r;
+        n -= static_cast<std::size_t>(r);
+    }
+}
+
+// Клиент: копит кадры и отправляет их одной записью — в flush() или когда накопилось
+// flushBytes, так что частые мелкие дельты не стоят системного вызова и пакета каждая.
+class AggClient {
+public:
+    explicit AggClient(const Endpoint& ep, std::size_t flushBytes = 64 << 10)
+        : fd_(openSocket(ep, false)), flushBytes_(flushBytes) {}
+    ~AggClient() {
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    AggClient(const AggClient&) = delete;
+    AggClient& operator=(const AggClient&) = delete;
+
+    void enqueue(const std::string& frame) {
+        pending_ += frame;
+        if (pending_.size() >= flushBytes_) flush();
+    }
+
+    void flush() {
+        if (pending_.empty()) return;
+        writeAll(fd_, pending_);
+        bytesSent_ += pending_.size();
+        writes_++;
+        pending_.clear();
+    }
+
+    double query(const std::string& name, bool* found = nullptr) {
+        enqueue(queryFrame(name));
+        flush();
+        for (;;) {
+            char hdr[5];
+            readAll(fd_, hdr, 5);
+            std::uint32_t len;
+            std::memcpy(&len, hdr, 4);
+            if (len == 0 || len > kMaxReplyFrame) throw std::runtime_error("agg: bad frame");
+            std::string body(len - 1, '\0');
+            readAll(fd_, &body[0], body.size());
+            Reader r(body.data(), body.size());
+            if (hdr[4] == Error) throw std::runtime_error("aggregator: " + r.str());
+            if (hdr[4] != Estimate) continue;
+            bool ok = r.u8() != 0;
+            double e = r.f64();
+            if (found) *found = ok;
+            return e;
+        }
+    }
+
+    std::uint64_t bytesSent() const { return bytesSent_; }
+    std::uint64_t writes() const { return writes_; }
+
+private:
+    int fd_;
+    std::size_t flushBytes_;
+    std::string pending_;
+    std::uint64_t bytesSent_ = 0;
+    std::uint64_t writes_ = 0;
+};
+
+} // namespace agg
@@ -0,0 +1,187 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "HyperLogLog.hpp"
+#include "HyperLogLog4.hpp"
+#include "SparseHyperLogLog.hpp"
+
+// Подбор параметров скетча по бюджету памяти и целевой ошибке — то, что раньше
+// делалось чтением вывода choose_B_test.
+
+enum class RegisterEncoding {
+    Byte,    // HyperLogLog: байт на регистр, самый быстрый
+    Packed4, // HyperLogLog4: 4 бита на регистр
+    Sparse,  // SparseHyperLogLog: 4 байта на ненулевой регистр + буфер, для малых кардинальностей
+};
+
+inline const char* encodingName(RegisterEncoding e) {
+    switch (e) {
+    case RegisterEncoding::Byte: return "byte";
+    case RegisterEncoding::Packed4: return "packed4";
+    case RegisterEncoding::Sparse: return "sparse";
+    }
+    return "?";
+}
+
+struct SketchRequirements {
+    double targetError = 0.01;           // относительная стандартная ошибка
+    std::size_t budgetBytes = 0;         // 0 — без ограничения
+    std::uint64_t expectedCardinality = 0; // 0 — неизвестна
+    // учитывать в бюджете сам объект скетча и заголовки его блоков в куче (для наборов
+    // из многих мелких скетчей, где это сравнимо с регистрами)
+    bool includeObjectOverhead = false;
+};
+
+struct SketchConfig {
+    int B = 14;
+    RegisterEncoding encoding = RegisterEncoding::Byte;
+    int hashBits = 32;
+    std::size_t bytes = 0;         // регистры, как их считает memoryBytes(), — оценка сверху
+    std::size_t overheadBytes = 0; // объект и блоки в куче; в бюджете, только если includeObjectOverhead
+    double expectedError = 0.0; // 1.04 / sqrt(m)
+    bool meetsTarget = true;    // false — бюджет не позволил достичь targetError
+};
+
+constexpr int kMinTunedB = 4;
+constexpr int kMaxTunedB = 26;
+
+inline double hllRelativeError(int B) { return 1.04 / std::sqrt(static_cast<double>(1u << B)); }
+
+// Сколько регистров станут ненулевыми при n уникальных: m (1 - e^{-n/m}).
+inline double expectedNonZero(int B, std::uint64_t n) {
+    double m = static_cast<double>(1u << B);
+    return m * (1.0 - std::exp(-static_cast<double>(n) / m));
+}
+
+// memoryBytes() скетча на всём пути до expectedCardinality уникальных (оценка сверху).
+inline std::size_t encodingBytes(int B, RegisterEncoding e, std::uint64_t expectedCardinality) {
+    std::size_t m = std::size_t(1) << B;
+    switch (e) {
+    case RegisterEncoding::Byte: return m;
+    case RegisterEncoding::Packed4: return (m + 1) / 2;
+    case RegisterEncoding::Sparse: {
+        // Пары по 4 байта; ёмкость отсортированного массива после вливания буфера больше
+        // числа пар на размер буфера, и сам буфер — ещё pendingLimit(pairs).
+        // Разреженный вид живёт, пока пары меньше m байт; без оценки кардинальности
+        // берётся этот предел.
+        std::size_t pairs = m / sizeof(std::uint32_t);
+        if (expectedCardinality != 0) {
+            pairs = std::min(pairs, static_cast<std::size_t>(std::ceil(expectedNonZero(B, expectedCardinality))));
+        }
+        return (pairs + 2 * SparseHyperLogLog::pendingLimit(pairs)) * sizeof(std::uint32_t);
+    }
+    }
+    return m;
+}
+
+// Заголовок и выравнивание блока malloc (glibc, 64 бит).
+constexpr std::size_t kHeapBlockOverhead = 16;
+
+// Объект скетча (как его создаёт makeSketch — отдельным блоком в куче) и заголовки
+// блоков с регистрами.
+inline std::size_t sketchOverheadBytes(RegisterEncoding e) {
+    switch (e) {
+    case RegisterEncoding::Byte: return sizeof(HyperLogLog) + 2 * kHeapBlockOverhead;
+    case RegisterEncoding::Packed4: return sizeof(HyperLogLog4) + 2 * kHeapBlockOverhead;
+    case RegisterEncoding::Sparse: return sizeof(SparseHyperLogLog) + 3 * kHeapBlockOverhead;
+    }
+    return 0;
+}
+
+// Наименьшее B, дающее targetError, затем самое быстрое хранение, укладывающееся в бюджет.
+// Если не укладывается ни одно, B уменьшается (meetsTarget = false).
+inline SketchConfig tuneSketch(const SketchRequirements& req) {
+    if (!(req.targetError > 0.0 && req.targetError < 1.0)) {
+        throw std::invalid_argument("tuneSketch: target error must be in (0, 1)");
+    }
+
+    // HashFunc 32-битный; дальше 2^32 / 30 работает поправка на коллизии хешей и ошибка
+    // растёт, а 64-битного хеша в проекте нет.
+    if (req.expectedCardinality > static_cast<std::uint64_t>(4294967296.0 / 30.0)) {
+        throw std::invalid_argument("tuneSketch: expected cardinality needs a 64-bit hash, HashFunc is 32-bit");
+    }
+
+    int need = static_cast<int>(std::ceil(std::log2(std::pow(1.04 / req.targetError, 2.0))));
+    need = std::max(kMinTunedB, std::min(need, kMaxTunedB));
+
+    const RegisterEncoding order[] = {RegisterEncoding::Byte, RegisterEncoding::Packed4, RegisterEncoding::Sparse};
+    for (int B = need; B >= kMinTunedB; --B) {
+        for (RegisterEncoding e : order) {
+            std::size_t bytes = encodingBytes(B, e, req.expectedCardinality);
+            std::size_t overhead = sketchOverheadBytes(e);
+            std::size_t charged = bytes + (req.includeObjectOverhead ? overhead : 0);
+            if (req.budgetBytes != 0 && charged > req.budgetBytes) continue;
+
+            SketchConfig c;
+            c.B = B;
+            c.encoding = e;
+            c.bytes = bytes;
+            c.overheadBytes = overhead;
+            c.expectedError = hllRelativeError(B);
+            c.meetsTarget = B == need && c.expectedError <= req.targetError * (1.0 + 1e-9);
+            return c;
+        }
+    }
+    throw std::invalid_argument("tuneSketch: budget of " + std::to_string(req.budgetBytes) +
+                                " bytes is too small for any sketch");
+}
+
+// Общий бюджет на keys скетчей (например, счётчик уникальных на каждый ключ). На ключ
+// учитываются регистры и объект скетча; память контейнера с ключами — забота вызывающего.
+inline SketchConfig tuneFleet(std::size_t totalBudgetBytes, std::size_t keys, SketchRequirements req) {
+    if (keys == 0) throw std::invalid_argument("tuneFleet: no keys");
+    req.budgetBytes = totalBudgetBytes / keys;
+    req.includeObjectOverhead = true;
+    if (req.budgetBytes == 0) throw std::invalid_argument("tuneFleet: budget is smaller than one byte per key");
+    return tuneSketch(req);
+}
+
+inline std::unique_ptr<CardinalitySketch> makeSketch(const SketchConfig& c) {
+    switch (c.encoding) {
+    case RegisterEncoding::Byte: return std::unique_ptr<CardinalitySketch>(new HyperLogLog(c.B));
+    case RegisterEncoding::Packed4: return std::unique_ptr<CardinalitySketch>(new HyperLogLog4(c.B));
+    case RegisterEncoding::Sparse: return std::unique_ptr<CardinalitySketch>(new SparseHyperLogLog(c.B));
+    }
+    throw std::invalid_argument("makeSketch: unknown encoding");
+}
+
+// Регистры скетча encoding в виде HyperLogLog (для свёртки, сверки, сохранения).
+inline HyperLogLog toDense(const CardinalitySketch& s, RegisterEncoding e) {
+    switch (e) {
+    case RegisterEncoding::Byte: return static_cast<const HyperLogLog&>(s);
+    case RegisterEncoding::Packed4: {
+        const auto& h4 = static_cast<const HyperLogLog4&>(s);
+        std::vector<std::uint8_t> regs(h4.m());
+        h4.copyRegisters(regs.data());
+        HyperLogLog h(h4.B());
+        h.loadRegisters(regs.data());
+        return h;
+    }
+    case RegisterEncoding::Sparse: return static_cast<const SparseHyperLogLog&>(s).toDense();
+    }
+    throw std::invalid_argument("toDense: unknown encoding");
+}
+
+// Скетч хранения e с регистрами d.
+inline std::unique_ptr<CardinalitySketch> makeSketchFrom(const HyperLogLog& d, RegisterEncoding e) {
+    switch (e) {
+    case RegisterEncoding::Byte: return std::unique_ptr<CardinalitySketch>(new HyperLogLog(d));
+    case RegisterEncoding::Packed4: {
+        std::unique_ptr<HyperLogLog4> h(new HyperLogLog4(d.B()));
+        h->loadRegisters(d.registers());
+        return std::unique_ptr<CardinalitySketch>(std::move(h));
+    }
+    case RegisterEncoding::Sparse: {
+        std::unique_ptr<SparseHyperLogLog> h(new SparseHyperLogLog(d.B()));
+        h->loadRegisters(d.registers());
+        return std::unique_ptr<CardinalitySketch>(std::move(h));
+    }
+    }
+    throw std::invalid_argument("makeSketchFrom: unknown encoding");
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include "HyperLogLog.hpp"
+#include "SketchConfig.hpp"
+
+// Набор скетчей по ключам с общим потолком памяти, в хранении, выбранном tuneFleet
+// (byte / packed4 / sparse). При приближении к пределу все скетчи сворачиваются на
+// одну ступень точности (B -> B - 1, память вдвое меньше, ошибка в sqrt(2) больше)
+// через плотные регистры и снова записываются в том же хранении; новые ключи сразу
+// создаются с текущим B.
+class SketchFleet {
+public:
+    SketchFleet(int B, int minB, RegisterEncoding encoding = RegisterEncoding::Byte)
+        : B_(B), minB_(minB), encoding_(encoding) {
+        if (minB_ < 4 || minB_ > B_ || B_ > 30) throw std::invalid_argument("SketchFleet: need 4 <= minB <= B <= 30");
+    }
+
+    explicit SketchFleet(const SketchConfig& c, int minB = kMinTunedB) : SketchFleet(c.B, minB, c.encoding) {}
+
+    void add(const std::string& key, std::uint32_t hash) {
+        auto it = sketches_.find(key);
+        if (it == sketches_.end()) {
+            SketchConfig c;
+            c.B = B_;
+            c.encoding = encoding_;
+            it = sketches_.emplace(key, makeSketch(c)).first;
+            bytes_ += it->second->memoryBytes();
+        }
+        if (encoding_ != RegisterEncoding::Sparse) {
+            it->second->addHash(hash);
+            return;
+        }
+        // разреженный скетч растёт со вставками
+        std::size_t before = it->second->memoryBytes();
+        it->second->addHash(hash);
+        bytes_ += it->second->memoryBytes() - before;
+    }
+
+    // 0, если ключа нет.
+    double estimate(const std::string& key) const {
+        auto it = sketches_.find(key);
+        if (it == sketches_.end()) return 0.0;
+        std::size_t before = it->second->memoryBytes();
+        double e = it->second->estimate(); // разреженный вливает буфер
+        bytes_ += it->second->memoryBytes() - before;
+        return e;
+    }
+
+    const CardinalitySketch* find(const std::string& key) const {
+        auto it = sketches_.find(key);
+        return it == sketches_.end() ? nullptr : it->second.get();
+    }
+
+    // Регистры скетча ключа в виде HyperLogLog; ключ должен быть в наборе.
+    HyperLogLog registers(const std::string& key) const {
+        const CardinalitySketch* s = find(key);
+        if (!s) throw std::out_of_range("SketchFleet: no sketch for " + key);
+        return toDense(*s, encoding_);
+    }
+
+    int B() const { return B_; }
+    RegisterEncoding encoding() const { return encoding_; }
+    std::size_t size() const { return sketches_.size(); }
+    std::size_t sketchBytes() const { return bytes_; }
+    std::size_t folds() const { return folds_; }
+
+    // Сворачивает, пока регистры не уложатся в limitBytes или не будет достигнут minB.
+    // Возвращает true, если лимит соблюдён.
+    bool shrinkTo(std::size_t limitBytes) {
+        while (bytes_ > limitBytes && B_ > minB_) {
+            B_--;
+            bytes_ = 0;
+            for (auto& kv : sketches_) {
+                kv.second = makeSketchFrom(toDense(*kv.second, encoding_).folded(B_), encoding_);
+                bytes_ += kv.second->memoryBytes();
+            }
+            folds_++;
+        }
+#ifdef __GLIBC__
+        malloc_trim(0); // освобождённые регистры возвращаются ОС, иначе RSS не падает
+#endif
+        return bytes_ <= limitBytes;
+    }
+
+    // Держит RSS процесса ниже rssLimit: когда RSS выше highWater * rssLimit, скетчи
+    // сворачиваются на величину превышения. Возвращает true, если была свёртка.
+    bool enforceRss(std::size_t rssLimit, double highWater = 0.9) {
+        std::size_t rss = currentRssBytes();
+        std::size_t mark = static_cast<std::size_t>(rssLimit * highWater);
+        if (rss <= mark) return false;
+        std::size_t excess = rss - mark;
+        int before = B_;
+        shrinkTo(excess >= bytes_ ? 0 : bytes_ - excess);
+        return B_ != before;
+    }
+
+    static std::size_t currentRssBytes() {
+        std::FILE* f = std::fopen("/proc/self/statm", "r");
+        if (!f) return 0;
+        unsigned long size = 0, resident = 0;
+        int n = std::fscanf(f, "%lu %lu", &size, &resident);
+        std::fclose(f);
+        if (n != 2) return 0;
+        return static_cast<std::size_t>(resident) * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+private:
+    int B_;
+    int minB_;
+    RegisterEncoding encoding_;
+    std::unordered_map<std::string, std::unique_ptr<CardinalitySketch>> sketches_;
+    mutable std::size_t bytes_ = 0; // меняется и в estimate(): разреженный скетч вливает буфер
+    std::size_t folds_ = 0;
+};
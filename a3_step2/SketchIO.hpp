@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "HyperLogLog.hpp"
+
+// Файл скетча: "HLL1", B (1 байт), seed хеш-функции (8 байт, little-endian),
+// затем m = 2^B байт регистров. Seed хранится, чтобы не слить скетчи,
+// построенные разными хеш-функциями.
+struct SketchFile {
+    std::uint64_t hashSeed = 0;
+    HyperLogLog hll;
+};
+
+inline void writeSketch(std::ostream& out, const HyperLogLog& hll, std::uint64_t hashSeed) {
+    char hdr[13] = {'H', 'L', 'L', '1', static_cast<char>(hll.B())};
+    for (int i = 0; i < 8; ++i) hdr[5 + i] = static_cast<char>((hashSeed >> (8 * i)) & 0xFF);
+    out.write(hdr, sizeof(hdr));
+    out.write(reinterpret_cast<const char*>(hll.registers()), hll.m());
+    if (!out) throw std::runtime_error("writeSketch: write failed");
+}
+
+inline SketchFile readSketch(std::istream& in) {
+    unsigned char hdr[13];
+    if (!in.read(reinterpret_cast<char*>(hdr), sizeof(hdr)) ||
+        hdr[0] != 'H' || hdr[1] != 'L' || hdr[2] != 'L' || hdr[3] != '1') {
+        throw std::runtime_error("readSketch: not a sketch file");
+    }
+    if (hdr[4] < 1 || hdr[4] > 30) throw std::runtime_error("readSketch: bad precision");
+    std::uint64_t seed = 0;
+    for (int i = 0; i < 8; ++i) seed |= static_cast<std::uint64_t>(hdr[5 + i]) << (8 * i);
+
+    SketchFile f{seed, HyperLogLog(hdr[4])};
+    std::vector<std::uint8_t> regs(f.hll.m());
+    if (!in.read(reinterpret_cast<char*>(regs.data()), regs.size())) {
+        throw std::runtime_error("readSketch: truncated register array");
+    }
+    f.hll.loadRegisters(regs.data());
+    return f;
+}
+
+inline void saveSketch(const std::string& path, const HyperLogLog& hll, std::uint64_t hashSeed) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw std::runtime_error("Cannot open file for writing: " + path);
+    writeSketch(out, hll, hashSeed);
+}
+
+inline SketchFile loadSketch(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot open file for reading: " + path);
+    return readSketch(in);
+}
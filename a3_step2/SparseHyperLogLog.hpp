@@ -0,0 +1,135 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+#include "HyperLogLog.hpp"
+
+// HLL для множества мелких скетчей: пока заполнено мало регистров, хранятся только
+// ненулевые — отсортированные пары (idx << 6 | reg) по 4 байта. Новые пары копятся
+// в буфере на pendingLimit(пар) = max(kPendingMin, пар / 8) и вливаются пачкой: буфер
+// выделяется при первой вставке и растёт вместе с массивом, так что пустой скетч
+// памяти не занимает, а слияние стоит O(1) на вставку в среднем. Когда пары занимают
+// столько же, сколько m байт плотных регистров, скетч один раз переходит в обычный HyperLogLog.
+class SparseHyperLogLog final : public CardinalitySketch {
+public:
+    explicit SparseHyperLogLog(int B) : B_(B), m_(1u << B) {
+        if (B_ <= 0 || B_ > 26) throw std::invalid_argument("SparseHyperLogLog: B must be in [1..26]");
+        L_ = 32 - B_;
+    }
+
+    void reset() override {
+        dense_.reset();
+        std::vector<std::uint32_t>().swap(sorted_);
+        std::vector<std::uint32_t>().swap(pending_);
+    }
+
+    void addHash(std::uint32_t x) override {
+        if (dense_) {
+            dense_->addHash(x);
+            return;
+        }
+        std::uint32_t idx = x >> (32 - B_);
+        std::uint8_t r = HyperLogLog::rho(x << B_, L_);
+        if (pending_.capacity() == 0) pending_.reserve(pendingLimit(sorted_.size()));
+        pending_.push_back(idx << 6 | r);
+        if (pending_.size() == pending_.capacity()) flush();
+    }
+
+    double estimate() const override {
+        flush();
+        if (dense_) return dense_->estimate();
+        double Z = static_cast<double>(m_ - sorted_.size());
+        for (std::uint32_t e : sorted_) Z += std::ldexp(1.0, -static_cast<int>(e & 63));
+        return HyperLogLog::estimateFrom(Z, static_cast<int>(m_ - sorted_.size()), m_);
+    }
+
+    std::size_t memoryBytes() const override {
+        if (dense_) return dense_->memoryBytes();
+        return (sorted_.capacity() + pending_.capacity()) * sizeof(std::uint32_t);
+    }
+
+    std::string name() const override { return "SparseHLL(B=" + std::to_string(B_) + ")"; }
+
+    // Размер буфера новых пар при pairs парах в отсортированном массиве.
+    static constexpr std::size_t kPendingMin = 16;
+    static std::size_t pendingLimit(std::size_t pairs) { return std::max(kPendingMin, pairs / 8); }
+
+    int B() const { return B_; }
+    std::uint32_t m() const { return m_; }
+    bool isSparse() const { return !dense_; }
+
+    // Заменяет регистры m байтами src (например, свёрнутыми); если ненулевых много,
+    // скетч сразу плотный.
+    void loadRegisters(const std::uint8_t* src) {
+        std::size_t nz = 0;
+        for (std::uint32_t i = 0; i < m_; ++i) {
+            if (src[i] > L_ + 1) throw std::invalid_argument("SparseHyperLogLog: register value out of range");
+            nz += src[i] != 0;
+        }
+        reset();
+        sorted_.reserve(nz);
+        for (std::uint32_t i = 0; i < m_; ++i) {
+            if (src[i] != 0) sorted_.push_back(i << 6 | src[i]);
+        }
+        maybeDensify();
+    }
+
+    // Плотный эквивалент (для merge, сохранения, свёртки).
+    HyperLogLog toDense() const {
+        flush();
+        if (dense_) return *dense_;
+        return densify();
+    }
+
+private:
+    int B_;
+    int L_;
+    std::uint32_t m_;
+    // estimate() логически константна, но вливает накопленный буфер (и может перейти в плотный вид)
+    mutable std::vector<std::uint32_t> sorted_;
+    mutable std::vector<std::uint32_t> pending_;
+    mutable std::unique_ptr<HyperLogLog> dense_;
+
+    HyperLogLog densify() const {
+        std::vector<std::uint8_t> regs(m_, 0);
+        for (std::uint32_t e : sorted_) regs[e >> 6] = static_cast<std::uint8_t>(e & 63);
+        HyperLogLog h(B_);
+        h.loadRegisters(regs.data());
+        return h;
+    }
+
+    // Сортирует буфер и сливает с sorted_, оставляя по idx максимальный reg.
+    void flush() const {
+        if (pending_.empty()) return;
+        std::sort(pending_.begin(), pending_.end());
+        std::vector<std::uint32_t> merged;
+        merged.reserve(sorted_.size() + pending_.size());
+        std::merge(sorted_.begin(), sorted_.end(), pending_.begin(), pending_.end(),
+                   std::back_inserter(merged));
+
+        // при равных idx пары идут по возрастанию reg — оставляем последнюю
+        std::size_t out = 0;
+        for (std::size_t i = 0; i < merged.size(); ++i) {
+            if (out > 0 && (merged[out - 1] >> 6) == (merged[i] >> 6)) merged[out - 1] = merged[i];
+            else merged[out++] = merged[i];
+        }
+        merged.resize(out);
+        sorted_.swap(merged);
+        // буфер под новый размер массива; выделится при следующей вставке
+        std::vector<std::uint32_t>().swap(pending_);
+        maybeDensify();
+    }
+
+    void maybeDensify() const {
+        if (sorted_.size() * sizeof(std::uint32_t) < m_) return;
+        dense_.reset(new HyperLogLog(densify()));
+        std::vector<std::uint32_t>().swap(sorted_);
+        std::vector<std::uint32_t>().swap(pending_);
+    }
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Кольцевой буфер один производитель / один потребитель без блокировок.
+// push() ждёт, пока освободится место (backpressure), pop() — пока появится элемент
+// или очередь закроют. Ожидание: сначала короткий спин, затем yield.
+template <class T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity) {
+        std::size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        if (cap < 2) cap = 2;
+        slots_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const { return slots_.size(); }
+
+    std::size_t size() const {
+        std::size_t t = tail_.load(std::memory_order_acquire);
+        std::size_t h = head_.load(std::memory_order_acquire);
+        return t - h;
+    }
+
+    bool tryPush(T& v) {
+        std::size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - headCache_ == slots_.size()) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (t - headCache_ == slots_.size()) return false;
+        }
+        slots_[t & mask_] = std::move(v);
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        std::size_t h = head_.load(std::memory_order_relaxed);
+        if (h == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (h == tailCache_) return false;
+        }
+        out = std::move(slots_[h & mask_]);
+        head_.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    void push(T v) {
+        std::size_t t = tail_.load(std::memory_order_relaxed);
+        std::size_t occ = t - head_.load(std::memory_order_acquire);
+        occupancySum_ += occ;
+        pushes_++;
+        if (occ > maxOccupancy_) maxOccupancy_ = occ;
+
+        if (tryPush(v)) return;
+        producerStalls_++;
+        for (unsigned spin = 0; !tryPush(v); ++spin) backoff(spin);
+    }
+
+    // false — очередь закрыта и пуста.
+    bool pop(T& out) {
+        if (tryPop(out)) return true;
+        consumerStalls_++;
+        for (unsigned spin = 0;; ++spin) {
+            if (tryPop(out)) return true;
+            if (closed_.load(std::memory_order_acquire)) return tryPop(out);
+            backoff(spin);
+        }
+    }
+
+    void close() { closed_.store(true, std::memory_order_release); }
+    bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+    // Статистика для настройки: средняя/максимальная заполненность в момент push
+    // и число ожиданий с каждой стороны. Читать после остановки стадий.
+    double meanOccupancy() const { return pushes_ ? static_cast<double>(occupancySum_) / pushes_ : 0.0; }
+    std::size_t maxOccupancy() const { return maxOccupancy_; }
+    std::uint64_t producerStalls() const { return producerStalls_; }
+    std::uint64_t consumerStalls() const { return consumerStalls_; }
+
+private:
+    std::vector<T> slots_;
+    std::size_t mask_ = 0;
+
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t tailCache_ = 0;          // поле потребителя
+    std::uint64_t consumerStalls_ = 0;
+
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t headCache_ = 0;          // поля производителя
+    std::uint64_t producerStalls_ = 0;
+    std::uint64_t pushes_ = 0;
+    std::uint64_t occupancySum_ = 0;
+    std::size_t maxOccupancy_ = 0;
+
+    alignas(64) std::atomic<bool> closed_{false};
+
+    static void backoff(unsigned spin) {
+        if (spin < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } else {
+            std::this_thread::yield();
+        }
+    }
+};
@@ -0,0 +1,296 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "RandomStreamGen.hpp"
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+#include "HyperLogLog4.hpp"
+#include "LinearCounting.hpp"
+#include "KmvSketch.hpp"
+#include "ExactF0.hpp"
+#include "ReportWriter.hpp"
+#include "RegisterMemory.hpp"
+#include "PerfCounters.hpp"
+
+// Запуск: bench_sketch --benchmark_out=bench.json --benchmark_out_format=json
+// (или цель bench_json в CMake).
+
+static std::vector<std::uint32_t> makeHashes(std::size_t n, std::uint64_t seed = 42) {
+    std::vector<std::uint32_t> out(n);
+    std::uint64_t x = seed;
+    for (auto& v : out) {
+        x += 0x9e3779b97f4a7c15ULL;
+        std::uint64_t z = x;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        v = static_cast<std::uint32_t>(z ^ (z >> 31));
+    }
+    return out;
+}
+
+static std::vector<std::string> makeStream(std::size_t n) {
+    RandomStreamGen::Config cfg;
+    cfg.seed = 42;
+    RandomStreamGen gen(cfg);
+    return gen.generate(n);
+}
+
+static void setNsPerItem(benchmark::State& state, const char* name, std::size_t itemsPerIter) {
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * itemsPerIter));
+    // время на один элемент в секундах; в консоли печатается с префиксом (n = нс)
+    state.counters[name] = benchmark::Counter(
+        static_cast<double>(itemsPerIter),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+// ---- insert: args = {B, N} ----
+
+template <class Sketch>
+static void BM_AddHash(benchmark::State& state) {
+    int B = static_cast<int>(state.range(0));
+    auto hashes = makeHashes(static_cast<std::size_t>(state.range(1)));
+    Sketch sketch(B);
+    for (auto _ : state) {
+        sketch.reset();
+        for (std::uint32_t x : hashes) sketch.addHash(x);
+        benchmark::ClobberMemory();
+    }
+    setNsPerItem(state, "t_insert", hashes.size());
+}
+
+static void BM_KmvAddHash(benchmark::State& state) {
+    std::size_t k = static_cast<std::size_t>(state.range(0));
+    auto hashes = makeHashes(static_cast<std::size_t>(state.range(1)));
+    KmvSketch sketch(k);
+    for (auto _ : state) {
+        sketch.reset();
+        for (std::uint32_t x : hashes) sketch.addHash(x);
+        benchmark::ClobberMemory();
+    }
+    setNsPerItem(state, "t_insert", hashes.size());
+}
+
+static void insertArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"B", "N"});
+    b->ArgsProduct({{10, 12, 14, 16}, {1 << 16, 1 << 20}});
+}
+
+BENCHMARK_TEMPLATE(BM_AddHash, HyperLogLog)->Apply(insertArgs);
+BENCHMARK_TEMPLATE(BM_AddHash, HyperLogLog4)->Apply(insertArgs);
+BENCHMARK_TEMPLATE(BM_AddHash, LinearCounting)->Apply(insertArgs);
+BENCHMARK(BM_KmvAddHash)->ArgNames({"k", "N"})->ArgsProduct({{1 << 10, 1 << 12}, {1 << 16, 1 << 20}});
+
+// ---- быстрый путь при насыщенных регистрах: B = 14, args = {N} ----
+// Хеши берутся из буфера 2^24, на каждом проходе XOR с новой солью, чтобы N до 10^9
+// не требовало N * 4 байт памяти. Baseline — прежний addHash: load / max / store всегда.
+
+static void plainAddHash(std::vector<std::uint8_t>& regs, int B, std::uint32_t x) {
+    std::uint32_t idx = x >> (32 - B);
+    std::uint32_t w = x << B;
+    std::uint8_t r = HyperLogLog::rho(w, 32 - B);
+    regs[idx] = std::max(regs[idx], r);
+}
+
+template <bool Skip>
+static void BM_HllLongStream(benchmark::State& state) {
+    const int B = 14;
+    std::size_t N = static_cast<std::size_t>(state.range(0));
+    static const auto buf = makeHashes(1 << 24);
+
+    HyperLogLog hll(B);
+    std::vector<std::uint8_t> regs(1u << B);
+    for (auto _ : state) {
+        hll.reset();
+        std::fill(regs.begin(), regs.end(), 0);
+        std::size_t left = N;
+        for (std::uint32_t pass = 0; left > 0; ++pass) {
+            std::uint32_t salt = pass * 0x9e3779b9u;
+            std::size_t n = std::min(left, buf.size());
+            for (std::size_t i = 0; i < n; ++i) {
+                if (Skip) hll.addHash(buf[i] ^ salt);
+                else plainAddHash(regs, B, buf[i] ^ salt);
+            }
+            left -= n;
+        }
+        benchmark::DoNotOptimize(regs.data());
+        benchmark::ClobberMemory();
+    }
+    setNsPerItem(state, "t_insert", N);
+    if (Skip) state.counters["min_register"] = hll.minRegister();
+}
+
+static void longStreamArgs(benchmark::internal::Benchmark* b) {
+    b->ArgName("N")->Arg(1000000)->Arg(10000000)->Arg(100000000)->Arg(1000000000);
+    b->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_TEMPLATE(BM_HllLongStream, false)->Apply(longStreamArgs);
+BENCHMARK_TEMPLATE(BM_HllLongStream, true)->Apply(longStreamArgs);
+
+// ---- estimate: args = {B} ----
+
+template <class Sketch>
+static void BM_Estimate(benchmark::State& state) {
+    Sketch sketch(static_cast<int>(state.range(0)));
+    for (std::uint32_t x : makeHashes(1 << 20)) sketch.addHash(x);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sketch.estimate());
+    }
+    setNsPerItem(state, "t_estimate", 1);
+}
+
+BENCHMARK_TEMPLATE(BM_Estimate, HyperLogLog)->ArgName("B")->DenseRange(10, 16, 2);
+BENCHMARK_TEMPLATE(BM_Estimate, HyperLogLog4)->ArgName("B")->DenseRange(10, 16, 2);
+
+// ---- hash: args = {длина строки} ----
+
+static void BM_HashFunc(benchmark::State& state) {
+    std::size_t len = static_cast<std::size_t>(state.range(0));
+    std::vector<std::string> keys;
+    for (auto x : makeHashes(1024)) {
+        std::string s(len, 'a');
+        for (std::size_t j = 0; j < len; ++j) s[j] = static_cast<char>('a' + ((x >> (j % 28)) & 15));
+        keys.push_back(std::move(s));
+    }
+    HashFuncGen hgen(777);
+    auto h = hgen.make();
+    for (auto _ : state) {
+        for (const auto& s : keys) benchmark::DoNotOptimize(h(s));
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * keys.size() * len));
+    setNsPerItem(state, "t_hash", keys.size());
+}
+
+BENCHMARK(BM_HashFunc)->ArgName("len")->Arg(1)->Arg(8)->Arg(15)->Arg(30)->Arg(256);
+
+// ---- генерация потока: args = {N} ----
+
+static void BM_StreamGen(benchmark::State& state) {
+    std::size_t N = static_cast<std::size_t>(state.range(0));
+    RandomStreamGen::Config cfg;
+    cfg.seed = 42;
+    RandomStreamGen gen(cfg);
+    for (auto _ : state) {
+        auto stream = gen.generate(N);
+        benchmark::DoNotOptimize(stream.data());
+    }
+    setNsPerItem(state, "t_string", N);
+}
+
+BENCHMARK(BM_StreamGen)->ArgName("N")->Arg(1 << 16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+
+// ---- точное F0: args = {N} ----
+
+static void BM_ExactF0Prefix(benchmark::State& state) {
+    std::size_t N = static_cast<std::size_t>(state.range(0));
+    auto stream = makeStream(N);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(exactF0Prefix(stream, N));
+    }
+    setNsPerItem(state, "t_insert", N);
+}
+
+BENCHMARK(BM_ExactF0Prefix)->ArgName("N")->Arg(1 << 16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+
+// ---- вывод отчёта: args = {строк} ----
+// Baseline — прежний способ: ofstream + ostringstream с locale на каждое число.
+
+static std::string ostreamExcelDouble(double x, int precision) {
+    std::ostringstream oss;
+    oss.imbue(std::locale::classic());
+    oss << std::fixed << std::setprecision(precision) << x;
+    std::string s = oss.str();
+    for (char& c : s) {
+        if (c == '.') c = ',';
+    }
+    while (s.size() > 1 && s.back() == '0') s.pop_back();
+    if (!s.empty() && s.back() == ',') s.pop_back();
+    return s;
+}
+
+static void BM_ReportOstream(benchmark::State& state) {
+    std::size_t rows = static_cast<std::size_t>(state.range(0));
+    const std::string path = "bench_report_ostream.csv";
+    for (auto _ : state) {
+        std::ofstream out(path);
+        out << "step;processed;mean_est;std_est\n";
+        for (std::size_t t = 0; t < rows; ++t) {
+            out << (t + 1) << ";" << t * 20000 << ";"
+                << ostreamExcelDouble(t * 0.97 + 0.123, 3) << ";"
+                << ostreamExcelDouble(t * 0.01 + 0.5, 3) << "\n";
+        }
+    }
+    std::remove(path.c_str());
+    setNsPerItem(state, "t_row", rows);
+}
+
+static void BM_ReportWriter(benchmark::State& state) {
+    std::size_t rows = static_cast<std::size_t>(state.range(0));
+    const std::string path = "bench_report_writer.csv";
+    for (auto _ : state) {
+        ReportWriter out(path, {"step", "processed", "mean_est", "std_est"});
+        for (std::size_t t = 0; t < rows; ++t) {
+            out.field(t + 1).field(t * 20000).field(t * 0.97 + 0.123, 3).field(t * 0.01 + 0.5, 3);
+            out.endRow();
+        }
+    }
+    std::remove(path.c_str());
+    setNsPerItem(state, "t_row", rows);
+}
+
+// ---- парк скетчей и TLB: args = {память регистров, число скетчей} ----
+// 0 — обычная куча, 1 — арена на 4 KiB страницах, 2 — арена + THP, 3 — арена + hugetlbfs.
+// Обновления идут в случайный скетч, поэтому при 64 MiB регистров на 4 KiB страницах
+// почти каждое обращение — промах dTLB. dtlb_miss — промахи на обновление (perf_event_open),
+// -1, если счётчик недоступен.
+
+static void BM_FleetUpdate(benchmark::State& state) {
+    const int B = 10;
+    const int mode = static_cast<int>(state.range(0));
+    const std::size_t F = static_cast<std::size_t>(state.range(1));
+    const HugePages pages[] = {HugePages::None, HugePages::None, HugePages::Transparent, HugePages::Explicit};
+
+    std::unique_ptr<RegisterArena> arena;
+    if (mode > 0) arena.reset(new RegisterArena(pages[mode]));
+    std::vector<HyperLogLog> fleet;
+    fleet.reserve(F);
+    for (std::size_t i = 0; i < F; ++i) fleet.emplace_back(B, arena.get());
+
+    static const auto ops = makeHashes(1 << 22, 7);
+    static const auto hashes = makeHashes(1 << 22, 8);
+    PerfCounter dtlb = PerfCounter::dtlbReadMisses();
+    std::uint64_t misses = 0;
+    for (auto _ : state) {
+        dtlb.start();
+        for (std::size_t i = 0; i < ops.size(); ++i) fleet[ops[i] % F].addHash(hashes[i]);
+        dtlb.stop();
+        misses += dtlb.read();
+    }
+    setNsPerItem(state, "t_update", ops.size());
+    state.counters["dtlb_miss"] = dtlb.available()
+        ? static_cast<double>(misses) / (static_cast<double>(state.iterations()) * ops.size())
+        : -1.0;
+    if (arena) {
+        ArenaStats st = arena->stats();
+        state.counters["hugetlb_chunks"] = static_cast<double>(st.hugetlbChunks);
+        state.counters["thp_chunks"] = static_cast<double>(st.thpChunks);
+    }
+}
+
+BENCHMARK(BM_FleetUpdate)
+    ->ArgNames({"mem", "F"})
+    ->ArgsProduct({{0, 1, 2, 3}, {1 << 10, 1 << 16}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ReportOstream)->ArgName("rows")->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReportWriter)->ArgName("rows")->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "RandomStreamGen.hpp"
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+#include "Checkpoint.hpp"
+#include "ReportWriter.hpp"
+
+// checkpoint_run [N=2000000] [every=100000] [--crash-at K] [--ckpt PATH]
+//
+// Прогон как в stage2_run, но с контрольными точками в PATH (checkpoint_run.ckpt).
+// --crash-at K завершает процесс через _Exit сразу после K-го элемента, без деструкторов
+// и сброса буферов — как при падении. Следующий запуск продолжает с последней записанной
+// точки; checkpoint_run.csv совпадает с прогоном без падения.
+
+int main(int argc, char** argv) {
+    std::size_t N = 2000000;
+    CheckpointOptions opt;
+    opt.path = "checkpoint_run.ckpt";
+    opt.every = 100000;
+    std::size_t crashAt = 0;
+
+    try {
+        int pos = 0;
+        for (int i = 1; i < argc; ++i) {
+            std::string a = argv[i];
+            if (a == "--crash-at" && i + 1 < argc) crashAt = std::strtoull(argv[++i], nullptr, 10);
+            else if (a == "--ckpt" && i + 1 < argc) opt.path = argv[++i];
+            else if (pos == 0 && ++pos) N = std::strtoull(a.c_str(), nullptr, 10);
+            else if (pos == 1 && ++pos) opt.every = std::strtoull(a.c_str(), nullptr, 10);
+            else throw std::invalid_argument("unexpected argument " + a);
+        }
+        if (N == 0) throw std::invalid_argument("N must be positive");
+
+        const int B = 14;
+        RandomStreamGen::Config cfg;
+        cfg.seed = 42;
+        RandomStreamGen gen(cfg);
+        auto stream = gen.generate(N);
+        auto steps = RandomStreamGen::prefixSizesByPercent(N, 10);
+
+        HashFuncGen hgen(777);
+        auto h = hgen.make();
+        HyperLogLog hll(B);
+
+        auto c = loadCheckpoint(opt.path);
+        if (c && checkpointMismatch(c->id, makeCheckpointIdentity(B, h, stream, steps)).empty()) {
+            std::cout << "Resuming from element " << c->offset << " (" << c->results.size() << " steps done)\n";
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        auto res = processOneStreamResumable(stream, h, hll, steps, opt, [&](std::size_t processed) {
+            if (processed == crashAt) {
+                std::cout << "Crashing after element " << processed << std::endl;
+                std::_Exit(3);
+            }
+        });
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        ReportWriter out("checkpoint_run.csv", {"step", "processed", "F0_true", "N_est", "std_err"});
+        for (std::size_t t = 0; t < res.size(); ++t) {
+            out.field(t + 1)
+               .field(res[t].processed)
+               .field(res[t].F0)
+               .field(res[t].Nt, 3)
+               .field(res[t].stdErr, 3);
+            out.endRow();
+        }
+        std::cout << "Saved: checkpoint_run.csv; N=" << N << ", checkpoint every " << opt.every
+                  << " elements, " << sec << " s\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
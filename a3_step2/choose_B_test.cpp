@@ -6,9 +6,9 @@
 #include <cmath>
 #include <cstdint>
 
-#include "RandomStreamGen.cpp"
-#include "HashFuncGen.cpp"
-#include "HyperLogLog.cpp"
+#include "RandomStreamGen.hpp"
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
 
 static inline int clz32(std::uint32_t x) {
     return __builtin_clz(x);
@@ -0,0 +1,91 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "RandomStreamGen.hpp"
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+#include "SketchAggregation.hpp"
+
+// Продюсер / клиент для hll_aggd.
+//
+//   hll_agg_client --unix PATH|--tcp PORT send NAME [N=1000000] [flushEvery=100000] [streamSeed=42]
+//   hll_agg_client --unix PATH|--tcp PORT full NAME [N=1000000] [streamSeed=42]
+//   hll_agg_client --unix PATH|--tcp PORT query NAME
+//
+// send строит локальный HyperLogLog по потоку RandomStreamGen и каждые flushEvery
+// элементов ставит в очередь кадр только с изменившимися с прошлого раза регистрами;
+// кадры уходят пачками (см. AggClient) и в конце, перед запросом оценки.
+
+int main(int argc, char** argv) {
+    if (argc < 5) {
+        std::cerr << "usage: hll_agg_client --unix PATH|--tcp PORT send|full|query NAME [N] [flushEvery] [streamSeed]\n";
+        return 2;
+    }
+
+    const int B = 14;
+    const std::uint64_t hashSeed = 777;
+
+    try {
+        agg::Endpoint ep = agg::parseEndpoint(argv[1], argv[2]);
+        const std::string mode = argv[3];
+        const std::string name = argv[4];
+        agg::AggClient client(ep);
+
+        if (mode == "query") {
+            bool found = false;
+            double e = client.query(name, &found);
+            if (!found) {
+                std::cerr << "no sketch named " << name << "\n";
+                return 1;
+            }
+            std::cout << e << "\n";
+            return 0;
+        }
+
+        const bool full = mode == "full";
+        if (!full && mode != "send") throw std::invalid_argument("unknown mode " + mode);
+
+        std::size_t N = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 1000000;
+        std::size_t flushEvery = !full && argc > 6 ? std::strtoull(argv[6], nullptr, 10) : 100000;
+        std::uint64_t streamSeed = argc > (full ? 6 : 7) ? std::strtoull(argv[full ? 6 : 7], nullptr, 10) : 42;
+        if (flushEvery == 0) flushEvery = N;
+
+        RandomStreamGen::Config cfg;
+        cfg.seed = streamSeed;
+        RandomStreamGen gen(cfg);
+        auto stream = gen.generate(N);
+
+        HashFunc h = HashFuncGen(hashSeed).make(); // как в hll_count / pipeline_run
+        HyperLogLog hll(B);
+        agg::DeltaTracker delta(B);
+        std::size_t streamBytes = 0;
+        std::size_t frames = 0;
+
+        for (std::size_t i = 0; i < stream.size(); ++i) {
+            hll.addHash(h(stream[i]));
+            streamBytes += stream[i].size() + 1;
+            if (!full && ((i + 1) % flushEvery == 0 || i + 1 == stream.size())) {
+                std::string f = delta.collect(name, hll, hashSeed);
+                if (!f.empty()) {
+                    client.enqueue(f);
+                    frames++;
+                }
+            }
+        }
+        if (full) {
+            client.enqueue(agg::fullFrame(name, hll, hashSeed));
+            frames++;
+        }
+
+        double remote = client.query(name); // сначала уходит очередь
+        std::cout << "sent " << frames << " frames in " << client.writes() << " writes (the last with the query), "
+                  << client.bytesSent() << " bytes for "
+                  << N << " elements (" << streamBytes << " bytes of input); "
+                  << "local estimate=" << hll.estimate() << ", aggregated estimate=" << remote << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "hll_agg_client: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,242 @@
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "HyperLogLog.hpp"
+#include "SketchAggregation.hpp"
+
+// hll_aggd --unix PATH | --tcp PORT [maxB=18]
+//
+// Принимает от продюсеров кадры Full / Delta (см. SketchAggregation.hpp), сливает
+// их в именованные скетчи поэлементным max и отвечает на Query. Один поток, poll().
+// TCP слушает только 127.0.0.1. Останавливается по SIGINT / SIGTERM.
+// Скетчи точнее maxB отклоняются; кадр длиннее наибольшего допустимого при maxB
+// закрывает соединение до буферизации, так что клиент держит в памяти сервера
+// не больше одного такого кадра.
+
+static volatile std::sig_atomic_t gStop = 0;
+
+static void onSignal(int) { gStop = 1; }
+
+struct Entry {
+    std::uint64_t seed;
+    HyperLogLog hll;
+    std::uint64_t updates = 0;
+};
+
+struct Connection {
+    int fd;
+    std::string in;
+    std::string out; // ответы, ещё не принятые сокетом
+};
+
+// Пока у клиента столько неотправленных ответов, его запросы не читаются: клиент,
+// переставший читать, тормозит только себя, а не поток poll() и других продюсеров.
+constexpr std::size_t kMaxPendingReplies = 1 << 20;
+
+class Aggregator {
+public:
+    explicit Aggregator(int maxB) : maxB_(maxB) {}
+
+    std::string handle(std::uint8_t type, agg::Reader& r) {
+        if (type == agg::Query) {
+            std::string name = r.str();
+            if (r.left() != 0) return error(name + ": trailing bytes in query");
+            agg::Writer w;
+            auto it = sketches_.find(name);
+            w.u8(it != sketches_.end() ? 1 : 0);
+            w.f64(it != sketches_.end() ? it->second.hll.estimate() : 0.0);
+            return w.frame(agg::Estimate);
+        }
+        if (type != agg::Full && type != agg::Delta) {
+            return error("unknown message type " + std::to_string(type));
+        }
+
+        std::string name = r.str();
+        int B = r.u8();
+        std::uint64_t seed = r.u64();
+        if (B < 4 || B > maxB_) return error(name + ": bad precision");
+
+        auto it = sketches_.find(name);
+        if (it != sketches_.end() && (it->second.hll.B() != B || it->second.seed != seed)) {
+            return error(name + ": B/seed differ from the stored sketch");
+        }
+
+        // Сначала кадр проверяется целиком: отклонённое обновление не создаёт скетч
+        // и не меняет существующий.
+        const std::uint32_t m = 1u << B;
+        const std::uint8_t maxReg = static_cast<std::uint8_t>(32 - B + 1);
+        const std::uint8_t* full = nullptr;
+        pairs_.clear();
+        if (type == agg::Full) {
+            full = reinterpret_cast<const std::uint8_t*>(r.bytes(m));
+            for (std::uint32_t i = 0; i < m; ++i) {
+                if (full[i] > maxReg) return error(name + ": register value out of range");
+            }
+        } else {
+            std::uint32_t count = r.u32();
+            if (count > m) return error(name + ": too many registers in delta");
+            std::uint32_t idx = 0;
+            for (std::uint32_t k = 0; k < count; ++k) {
+                std::uint32_t step = r.varint();
+                std::uint8_t v = r.u8();
+                if (step >= m - idx) return error(name + ": register index out of range");
+                if (v > maxReg) return error(name + ": register value out of range");
+                idx += step;
+                pairs_.emplace_back(idx, v);
+            }
+        }
+        if (r.left() != 0) return error(name + ": trailing bytes after registers");
+
+        if (it == sketches_.end()) it = sketches_.emplace(name, Entry{seed, HyperLogLog(B)}).first;
+        Entry& e = it->second;
+        // max по регистрам прямо в сохранённый скетч: дельта стоит O(число пар), а не O(m)
+        if (full) {
+            for (std::uint32_t i = 0; i < m; ++i) e.hll.raiseRegister(i, full[i]);
+        } else {
+            for (const auto& p : pairs_) e.hll.raiseRegister(p.first, p.second);
+        }
+        e.updates++;
+        return std::string();
+    }
+
+    std::size_t size() const { return sketches_.size(); }
+
+private:
+    int maxB_;
+    std::unordered_map<std::string, Entry> sketches_;
+    std::vector<std::pair<std::uint32_t, std::uint8_t>> pairs_; // разобранная дельта, переиспользуется
+
+    static std::string error(const std::string& msg) {
+        agg::Writer w;
+        w.str(msg);
+        return w.frame(agg::Error);
+    }
+};
+
+// Разбирает все полные кадры из буфера; false — соединение нужно закрыть.
+static bool drain(Connection& c, Aggregator& aggr, std::uint32_t maxFrame) {
+    std::size_t off = 0;
+    while (c.in.size() - off >= 5) {
+        std::uint32_t len;
+        std::memcpy(&len, c.in.data() + off, 4);
+        if (len == 0 || len > maxFrame) return false;
+        if (c.in.size() - off - 4 < len) break;
+
+        std::uint8_t type = static_cast<std::uint8_t>(c.in[off + 4]);
+        agg::Reader r(c.in.data() + off + 5, len - 1);
+        std::string reply;
+        try {
+            reply = aggr.handle(type, r);
+        } catch (const std::exception& e) {
+            agg::Writer w;
+            w.str(e.what());
+            reply = w.frame(agg::Error);
+        }
+        c.out += reply;
+        off += 4 + len;
+    }
+    c.in.erase(0, off);
+    return true;
+}
+
+// Отправляет сколько примет сокет, не блокируясь; false — соединение нужно закрыть.
+static bool flushReplies(Connection& c) {
+    std::size_t off = 0;
+    while (off < c.out.size()) {
+        ssize_t n = ::send(c.fd, c.out.data() + off, c.out.size() - off, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) return false;
+        off += static_cast<std::size_t>(n);
+    }
+    c.out.erase(0, off);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3 && argc != 4) {
+        std::cerr << "usage: hll_aggd --unix PATH | --tcp PORT [maxB=18]\n";
+        return 2;
+    }
+
+    try {
+        agg::Endpoint ep = agg::parseEndpoint(argv[1], argv[2]);
+        const int maxB = argc > 3 ? std::stoi(argv[3]) : 18;
+        if (maxB < 4 || maxB > 30) throw std::invalid_argument("maxB must be in [4, 30]");
+        const std::uint32_t maxFrame = agg::maxUpdateFrame(maxB);
+        int lfd = agg::openSocket(ep, true);
+
+        struct sigaction sa{};
+        sa.sa_handler = onSignal;
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+
+        std::cerr << "hll_aggd: listening on "
+                  << (ep.unixPath.empty() ? "127.0.0.1:" + std::to_string(ep.port) : ep.unixPath) << "\n";
+
+        Aggregator aggr(maxB);
+        std::vector<Connection> conns;
+        std::vector<char> buf(1 << 16);
+
+        while (!gStop) {
+            std::vector<pollfd> pfds;
+            pfds.push_back({lfd, POLLIN, 0});
+            for (const auto& c : conns) {
+                short events = c.out.size() < kMaxPendingReplies ? POLLIN : 0;
+                if (!c.out.empty()) events |= POLLOUT;
+                pfds.push_back({c.fd, events, 0});
+            }
+
+            int n = ::poll(pfds.data(), pfds.size(), 500);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                agg::sysCheck(false, "poll");
+            }
+
+            if (pfds[0].revents & POLLIN) {
+                int cfd = ::accept(lfd, nullptr, nullptr);
+                if (cfd >= 0) conns.push_back({cfd, std::string(), std::string()});
+            }
+
+            std::vector<Connection> alive;
+            for (std::size_t i = 0; i < conns.size(); ++i) {
+                Connection& c = conns[i];
+                short ev = pfds[i + 1].revents;
+                bool keep = true;
+                if (ev & POLLOUT) keep = flushReplies(c);
+                if (keep && (ev & (POLLIN | POLLHUP | POLLERR))) {
+                    ssize_t r = ::recv(c.fd, buf.data(), buf.size(), 0);
+                    if (r > 0) {
+                        c.in.append(buf.data(), static_cast<std::size_t>(r));
+                        keep = drain(c, aggr, maxFrame) && flushReplies(c);
+                    } else if (r == 0 || errno != EINTR) {
+                        keep = false;
+                    }
+                }
+                if (keep) alive.push_back(std::move(c));
+                else ::close(c.fd);
+            }
+            conns.swap(alive);
+        }
+
+        for (auto& c : conns) ::close(c.fd);
+        ::close(lfd);
+        if (!ep.unixPath.empty()) ::unlink(ep.unixPath.c_str());
+        std::cerr << "hll_aggd: stopped, " << aggr.size() << " sketches\n";
+    } catch (const std::exception& e) {
+        std::cerr << "hll_aggd: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+#include "IngestPipeline.hpp"
+#include "SketchIO.hpp"
+
+// Число уникальных строк (или значений в колонках) в файлах / stdin за O(2^B) памяти.
+// Аналог `sort -u | wc -l`, но оценка HyperLogLog с относительной ошибкой ~1.04 / sqrt(2^B).
+
+static const char* kUsage =
+    "usage: hll_count [options] [file ...]     (no files or '-' = stdin)\n"
+    "  -b B       precision, m = 2^B registers (4..30, default 14)\n"
+    "  -s SEED    hash seed (default 777), as in HashFuncGen(SEED) of the other tools;\n"
+    "             sketches merge only with equal seed and B\n"
+    "  -j N       files processed in parallel (default: hardware threads)\n"
+    "  -t N       hasher threads for a single input (default 2)\n"
+    "  -f LIST    count distinct values of these 1-based columns separately, e.g. 1,3\n"
+    "  -d CHAR    column delimiter for -f (default: tab)\n"
+    "  -o FILE    save the resulting sketch (with -f: FILE.<column>)\n"
+    "  -m FILE    merge a saved sketch into the result (repeatable)\n"
+    "  -p         also print a line per input file\n";
+
+struct Options {
+    int B = 14;
+    std::uint64_t seed = 777;
+    std::size_t jobs = 0;
+    std::size_t hashers = 2;
+    std::vector<int> columns;
+    char delim = '\t';
+    std::string savePath;
+    std::vector<std::string> mergePaths;
+    bool perFile = false;
+    std::vector<std::string> inputs;
+};
+
+// Неотрицательное целое целиком: atoi / strtoul молча берут "1x" как 1, а "-1" как 2^64 - 1.
+static std::uint64_t parseUnsigned(const std::string& s, const std::string& what, int base = 10) {
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long v = std::strtoull(s.c_str(), &end, base);
+    if (s.empty() || s[0] == '-' || s[0] == '+' || std::isspace(static_cast<unsigned char>(s[0])) ||
+        end != s.c_str() + s.size() || errno == ERANGE) {
+        throw std::invalid_argument("bad " + what + ": '" + s + "'");
+    }
+    return v;
+}
+
+static std::vector<int> parseColumns(const std::string& list) {
+    std::vector<int> cols;
+    std::size_t pos = 0;
+    while (pos <= list.size()) {
+        std::size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        std::uint64_t c = parseUnsigned(list.substr(pos, comma - pos), "column in -f");
+        if (c == 0 || c > 1000000) throw std::invalid_argument("bad column list: " + list);
+        cols.push_back(static_cast<int>(c));
+        pos = comma + 1;
+    }
+    std::sort(cols.begin(), cols.end());
+    cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    return cols;
+}
+
+static Options parseArgs(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + a);
+            return argv[++i];
+        };
+        if (a == "-b") o.B = static_cast<int>(std::min<std::uint64_t>(parseUnsigned(value(), "-b"), 99));
+        else if (a == "-s") o.seed = parseUnsigned(value(), "-s", 0);
+        else if (a == "-j") o.jobs = parseUnsigned(value(), "-j");
+        else if (a == "-t") o.hashers = parseUnsigned(value(), "-t");
+        else if (a == "-f") o.columns = parseColumns(value());
+        else if (a == "-d") {
+            std::string d = value();
+            if (d == "\\t") d = "\t";
+            if (d.size() != 1) throw std::invalid_argument("delimiter must be a single character");
+            o.delim = d[0];
+        }
+        else if (a == "-o") o.savePath = value();
+        else if (a == "-m") o.mergePaths.push_back(value());
+        else if (a == "-p") o.perFile = true;
+        else if (a == "-h" || a == "--help") {
+            std::cout << kUsage;
+            std::exit(0);
+        }
+        else if (a.size() > 1 && a[0] == '-') throw std::invalid_argument("unknown option " + a);
+        else o.inputs.push_back(a);
+    }
+    if (o.B < 4 || o.B > 30) throw std::invalid_argument("-b must be in [4..30]");
+    if (o.hashers == 0) o.hashers = 1;
+    if (o.jobs == 0) o.jobs = std::max(1u, std::thread::hardware_concurrency());
+    if (o.inputs.empty() && o.mergePaths.empty()) o.inputs.push_back("-");
+    if (!o.columns.empty() && !o.mergePaths.empty()) {
+        throw std::invalid_argument("-m cannot be combined with -f");
+    }
+    return o;
+}
+
+// Последовательное чтение блоками и разбиение на строки (как loadFromFile, без копий).
+template <class OnLine>
+static void scanLines(std::FILE* in, OnLine&& onLine) {
+    const std::size_t blockSize = 1 << 20;
+    std::vector<char> buf(blockSize);
+    std::size_t keep = 0;
+    for (;;) {
+        if (keep == buf.size()) buf.resize(buf.size() * 2);
+        std::size_t n = std::fread(buf.data() + keep, 1, buf.size() - keep, in);
+        if (n == 0) {
+            if (std::ferror(in)) throw std::runtime_error("read error");
+            if (keep > 0) {
+                std::size_t len = keep;
+                if (buf[len - 1] == '\r') len--;
+                onLine(std::string_view(buf.data(), len));
+            }
+            return;
+        }
+        const char* p = buf.data();
+        const char* end = p + keep + n;
+        for (;;) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (!nl) break;
+            std::size_t len = nl - p;
+            if (len > 0 && p[len - 1] == '\r') len--;
+            onLine(std::string_view(p, len));
+            p = nl + 1;
+        }
+        keep = end - p;
+        std::memmove(buf.data(), p, keep);
+    }
+}
+
+static long long rounded(double e) { return static_cast<long long>(std::llround(e)); }
+
+struct InputResult {
+    std::vector<HyperLogLog> sketches; // одна на колонку или одна на строки
+};
+
+static InputResult countInput(const std::string& path, const Options& o, const HashFunc& h,
+                              std::size_t hashers) {
+    std::FILE* in = stdin;
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> guard(nullptr, &std::fclose);
+    if (path != "-") {
+        in = std::fopen(path.c_str(), "rb");
+        if (!in) throw std::runtime_error("Cannot open file for reading: " + path);
+        guard.reset(in);
+    }
+
+    InputResult res;
+    if (o.columns.empty()) {
+        res.sketches.emplace_back(o.B);
+        if (hashers > 1) {
+            PipelineConfig cfg;
+            cfg.hashers = hashers;
+            IngestPipeline(h, cfg).run(in, res.sketches[0]);
+        } else {
+            HyperLogLog& hll = res.sketches[0];
+            scanLines(in, [&](std::string_view line) { hll.addHash(h(line)); });
+        }
+        return res;
+    }
+
+    for (std::size_t c = 0; c < o.columns.size(); ++c) res.sketches.emplace_back(o.B);
+    const int lastCol = o.columns.back();
+    scanLines(in, [&](std::string_view line) {
+        std::size_t slot = 0;
+        int col = 1;
+        std::size_t start = 0;
+        while (col <= lastCol && start <= line.size()) {
+            std::size_t stop = line.find(o.delim, start);
+            if (stop == std::string_view::npos) stop = line.size();
+            if (col == o.columns[slot]) {
+                res.sketches[slot].addHash(h(line.substr(start, stop - start)));
+                if (++slot == o.columns.size()) break;
+            }
+            start = stop + 1;
+            col++;
+        }
+    });
+    return res;
+}
+
+int main(int argc, char** argv) {
+    try {
+        Options o = parseArgs(argc, argv);
+        // та же функция, что у pipeline_run / stage2 при том же seed: скетчи сравнимы между утилитами
+        HashFunc h = HashFuncGen(o.seed).make();
+        const std::size_t slots = o.columns.empty() ? 1 : o.columns.size();
+
+        std::vector<HyperLogLog> total(slots, HyperLogLog(o.B));
+        for (const auto& path : o.mergePaths) {
+            SketchFile f = loadSketch(path);
+            if (f.hashSeed != o.seed || f.hll.B() != o.B) {
+                throw std::runtime_error(path + ": sketch was built with B=" + std::to_string(f.hll.B()) +
+                                         ", seed=" + std::to_string(f.hashSeed) + " (expected -b " +
+                                         std::to_string(o.B) + " -s " + std::to_string(o.seed) + ")");
+            }
+            total[0].merge(f.hll);
+        }
+
+        // Один вход — все потоки отдаются конвейеру, несколько — по файлу на поток.
+        // Готовый вход сразу вливается в total, так что память — O(jobs * 2^B) при любом
+        // числе файлов; для -p от входа остаются только оценки.
+        const std::size_t nIn = o.inputs.size();
+        const std::size_t hashers = nIn == 1 ? o.hashers : 1;
+        std::vector<std::vector<double>> perFile(o.perFile ? nIn : 0);
+        std::vector<std::string> errors(nIn);
+        std::atomic<std::size_t> next{0};
+        std::mutex totalMu;
+
+        auto worker = [&] {
+            for (std::size_t i; (i = next.fetch_add(1)) < nIn;) {
+                try {
+                    InputResult r = countInput(o.inputs[i], o, h, hashers);
+                    if (o.perFile) {
+                        for (const auto& sk : r.sketches) perFile[i].push_back(sk.estimate());
+                    }
+                    std::lock_guard<std::mutex> lk(totalMu);
+                    for (std::size_t c = 0; c < slots; ++c) total[c].merge(r.sketches[c]);
+                } catch (const std::exception& e) {
+                    errors[i] = e.what();
+                }
+            }
+        };
+        std::vector<std::thread> pool;
+        for (std::size_t t = 1; t < std::min(o.jobs, nIn); ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool) t.join();
+
+        for (std::size_t i = 0; i < nIn; ++i) {
+            if (!errors[i].empty()) throw std::runtime_error(errors[i]);
+        }
+
+        std::vector<double> totalEst;
+        for (const auto& sk : total) totalEst.push_back(sk.estimate());
+
+        auto printRow = [&](const std::vector<double>& est, const std::string& name) {
+            for (std::size_t c = 0; c < slots; ++c) {
+                std::cout << rounded(est[c]);
+                if (!o.columns.empty()) std::cout << "\tcol" << o.columns[c];
+                if (!name.empty()) std::cout << "\t" << name;
+                std::cout << "\n";
+            }
+        };
+
+        if (o.perFile) {
+            for (std::size_t i = 0; i < nIn; ++i) printRow(perFile[i], o.inputs[i]);
+            printRow(totalEst, "total");
+        } else {
+            printRow(totalEst, "");
+        }
+
+        if (!o.savePath.empty()) {
+            if (o.columns.empty()) {
+                saveSketch(o.savePath, total[0], o.seed);
+            } else {
+                for (std::size_t c = 0; c < slots; ++c) {
+                    saveSketch(o.savePath + "." + std::to_string(o.columns[c]), total[c], o.seed);
+                }
+            }
+        }
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "hll_count: " << e.what() << "\n" << kUsage;
+        return 2;
+    } catch (const std::exception& e) {
+        std::cerr << "hll_count: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
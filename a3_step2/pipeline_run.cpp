@@ -0,0 +1,97 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "RandomStreamGen.hpp"
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+#include "IngestPipeline.hpp"
+#include "RegisterMemory.hpp"
+#include "Instrumentation.hpp"
+
+// pipeline_run <file> [hashers=2] [B=14] [blockKiB=1024] [node=-1]
+// pipeline_run --generate <file> <N>      — записать поток RandomStreamGen в файл
+//
+// Печатает оценку, пропускную способность и заполненность очередей; для файлов
+// node >= 0 — потоки конвейера и регистры скетча на этом узле NUMA. Для файлов
+// до 1 GiB дополнительно прогоняет последовательный вариант (loadFromFile + цикл).
+
+static void printQueues(const PipelineStats& st) {
+    std::cout << "queue          cap  mean_occ  max_occ  producer_stalls  consumer_stalls\n";
+    for (const auto& q : st.queues) {
+        std::cout << std::left << std::setw(13) << q.name << std::right
+                  << std::setw(5) << q.capacity
+                  << std::setw(10) << std::fixed << std::setprecision(2) << q.meanOccupancy
+                  << std::setw(9) << q.maxOccupancy
+                  << std::setw(17) << q.producerStalls
+                  << std::setw(17) << q.consumerStalls << "\n";
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 4 && std::string(argv[1]) == "--generate") {
+        RandomStreamGen::Config cfg;
+        cfg.seed = 42;
+        RandomStreamGen gen(cfg);
+        RandomStreamGen::saveToFile(gen.generate(std::strtoull(argv[3], nullptr, 10)), argv[2]);
+        std::cout << "Saved: " << argv[2] << "\n";
+        return 0;
+    }
+    if (argc < 2) {
+        std::cerr << "usage: pipeline_run <file> [hashers=2] [B=14] [blockKiB=1024] [node=-1]\n"
+                  << "       pipeline_run --generate <file> <N>\n";
+        return 1;
+    }
+
+    const std::string path = argv[1];
+    PipelineConfig pcfg;
+    if (argc > 2) pcfg.hashers = std::strtoul(argv[2], nullptr, 10);
+    const int B = argc > 3 ? std::atoi(argv[3]) : 14;
+    if (argc > 4) pcfg.blockSize = std::strtoull(argv[4], nullptr, 10) << 10;
+    if (argc > 5) pcfg.numaNode = std::atoi(argv[5]);
+
+    const std::uint64_t hashSeed = 777;
+
+    try {
+        HashFuncGen hgen(hashSeed);
+        auto h = hgen.make();
+
+        std::unique_ptr<RegisterArena> arena;
+        if (pcfg.numaNode >= 0) arena.reset(new RegisterArena(HugePages::Transparent, pcfg.numaNode));
+        HyperLogLog hll(B, arena.get());
+        IngestPipeline pipe(h, pcfg);
+        auto st = pipe.runFile(path, hll);
+
+        std::cout << "Pipeline: lines=" << st.lines << ", bytes=" << st.bytes
+                  << ", estimate=" << std::setprecision(10) << hll.estimate() << std::setprecision(6)
+                  << ", time=" << st.seconds << " s"
+                  << ", " << st.mbPerSec() << " MB/s"
+                  << " (hashers=" << pcfg.hashers << ", block=" << (pcfg.blockSize >> 10) << " KiB)\n";
+        printQueues(st);
+        std::cout << "sketch stage idle polls: " << pipe.sketchStalls() << "\n";
+
+        if (st.bytes < (1ULL << 30)) {
+            auto t0 = std::chrono::steady_clock::now();
+            auto stream = RandomStreamGen::loadFromFile(path);
+            HyperLogLog serial(B);
+            for (const auto& s : stream) serial.addHash(h(s));
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            std::cout << "Serial:   lines=" << stream.size()
+                      << ", estimate=" << std::setprecision(10) << serial.estimate() << std::setprecision(6)
+                      << ", time=" << sec << " s"
+                      << ", " << (st.bytes / sec / 1e6) << " MB/s\n";
+        }
+
+        instr::printBreakdown(std::cout, instr::snapshot());
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -6,32 +6,22 @@
 #include <algorithm>
 #include <cmath>
 #include <limits>
-#include <cctype>
-
-static inline std::string trim(const std::string& s) {
-    std::size_t a = 0, b = s.size();
-    while (a < b && std::isspace((unsigned char)s[a])) a++;
-    while (b > a && std::isspace((unsigned char)s[b - 1])) b--;
-    return s.substr(a, b - a);
-}
-
-static inline std::vector<std::string> split(const std::string& line, char delim) {
-    std::vector<std::string> out;
-    std::string cur;
-    std::istringstream ss(line);
-    while (std::getline(ss, cur, delim)) out.push_back(trim(cur));
-    return out;
-}
-
-static inline double parseDouble(std::string s) {
-    s = trim(s);
-    for (char& c : s) if (c == ',') c = '.';
-    return std::stod(s);
-}
-
-static inline int parseInt(std::string s) {
-    s = trim(s);
-    return std::stoi(s);
+#include <filesystem>
+
+#include "CsvScanner.hpp"
+#include "Downsample.hpp"
+#include "ReportWriter.hpp"
+
+// plot_svg                              — graph1.svg и graph2.svg из stage2_example/stage2_stats
+// plot_svg FILE X Y [Y...] [-o OUT.svg] — ряды Y(X) из CSV (с заголовком) или .col
+//                                         (например, trajectory.col: processed F0_true N_est)
+//
+// Файл-спутник .col (ReportWriter) читается вместо CSV, если он не старше CSV.
+static bool freshSidecar(const std::string& csv) {
+    std::error_code ec;
+    auto col = csv + ".col";
+    if (!std::filesystem::exists(col, ec)) return false;
+    return std::filesystem::last_write_time(col, ec) >= std::filesystem::last_write_time(csv, ec) && !ec;
 }
 
 struct ExRow {
@@ -51,6 +41,7 @@ struct StRow {
 struct SvgCanvas {
     int W, H;
     int left = 80, right = 30, top = 30, bottom = 60;
+    std::size_t maxPoints = 2000; // предел точек на один ряд
 
     int plotW() const { return W - left - right; }
     int plotH() const { return H - top - bottom; }
@@ -97,6 +88,7 @@ static void drawAxesAndGrid(std::ofstream& out, const SvgCanvas& c,
                             const std::string& xLabel, const std::string& yLabel,
                             const std::string& title,
                             int xTicks = 10) {
+    xTicks = std::max(1, std::min(xTicks, 20));
 
     out << "<text class=\"title\" x=\"" << (c.W/2) << "\" y=\"18\" text-anchor=\"middle\">"
         << title << "</text>\n";
@@ -137,10 +129,11 @@ static void drawAxesAndGrid(std::ofstream& out, const SvgCanvas& c,
         << yLabel << "</text>\n";
 }
 
-static void drawPolyline(std::ofstream& out, const std::vector<std::pair<double,double>>& pts,
-                         double xmin, double xmax, double ymin, double ymax,
-                         const SvgCanvas& c, const std::string& stroke, int width = 2,
-                         const std::string& dashArray = "") {
+// Точки выводятся как есть; прореживание — забота вызывающего.
+static void drawPoints(std::ofstream& out, const std::vector<std::pair<double,double>>& pts,
+                       double xmin, double xmax, double ymin, double ymax,
+                       const SvgCanvas& c, const std::string& stroke, int width = 2,
+                       const std::string& dashArray = "") {
     out << "<polyline fill=\"none\" stroke=\"" << stroke << "\" stroke-width=\"" << width << "\"";
     if (!dashArray.empty()) out << " stroke-dasharray=\"" << dashArray << "\"";
     out << " points=\"";
@@ -150,6 +143,14 @@ static void drawPolyline(std::ofstream& out, const std::vector<std::pair<double,
     out << "\" />\n";
 }
 
+// Линия ряда, прореженная LTTB до c.maxPoints.
+static void drawPolyline(std::ofstream& out, const std::vector<std::pair<double,double>>& pts,
+                         double xmin, double xmax, double ymin, double ymax,
+                         const SvgCanvas& c, const std::string& stroke, int width = 2,
+                         const std::string& dashArray = "") {
+    drawPoints(out, lttb(pts, c.maxPoints), xmin, xmax, ymin, ymax, c, stroke, width, dashArray);
+}
+
 static void drawLegend(std::ofstream& out, const SvgCanvas& c,
                        const std::vector<std::pair<std::string,std::string>>& items) {
     int x0 = c.left + 10;
@@ -165,65 +166,82 @@ static void drawLegend(std::ofstream& out, const SvgCanvas& c,
     }
 }
 
+// up / lo — уже прореженные границы (minMaxEnvelope).
 static void drawBand(std::ofstream& out,
-                     const std::vector<std::pair<double,double>>& upper,
-                     const std::vector<std::pair<double,double>>& lower,
+                     const std::vector<std::pair<double,double>>& up,
+                     const std::vector<std::pair<double,double>>& lo,
                      double xmin, double xmax, double ymin, double ymax,
                      const SvgCanvas& c,
                      const std::string& fill, double opacity = 0.25) {
     out << "<polygon fill=\"" << fill << "\" fill-opacity=\"" << opacity
         << "\" stroke=\"none\" points=\"";
-    for (auto [x,y] : upper) {
+    for (auto [x,y] : up) {
         out << mapX(x, xmin, xmax, c) << "," << mapY(y, ymin, ymax, c) << " ";
     }
-    for (int i = (int)lower.size() - 1; i >= 0; --i) {
-        auto [x,y] = lower[i];
+    for (int i = (int)lo.size() - 1; i >= 0; --i) {
+        auto [x,y] = lo[i];
         out << mapX(x, xmin, xmax, c) << "," << mapY(y, ymin, ymax, c) << " ";
     }
     out << "\" />\n";
 }
 
 static std::vector<ExRow> readExample(const std::string& path) {
-    std::ifstream in(path);
-    if (!in) throw std::runtime_error("Cannot open: " + path);
-
     std::vector<ExRow> rows;
-    std::string line;
-    std::getline(in, line);
+    if (freshSidecar(path)) {
+        auto d = readColumnar(path + ".col");
+        const auto& step = d.column("step");
+        const auto& processed = d.column("processed");
+        const auto& f0 = d.column("F0_true");
+        const auto& n = d.column("N_est");
+        rows.reserve(d.rows);
+        for (std::size_t i = 0; i < d.rows; ++i) {
+            rows.push_back({(int)step[i], processed[i], f0[i], n[i]});
+        }
+        return rows;
+    }
+
+    CsvScanner in(path);
+    in.next();
 
-    while (std::getline(in, line)) {
-        if (trim(line).empty()) continue;
-        auto parts = split(line, ';');
-        if (parts.size() < 4) continue;
+    while (in.next()) {
+        if (in.blank() || in.size() < 4) continue;
 
         ExRow r;
-        r.step      = parseInt(parts[0]);
-        r.processed = parseDouble(parts[1]);
-        r.f0        = parseDouble(parts[2]);
-        r.n         = parseDouble(parts[3]);
+        r.step      = in.integer(0);
+        r.processed = in.number(1);
+        r.f0        = in.number(2);
+        r.n         = in.number(3);
         rows.push_back(r);
     }
     return rows;
 }
 
 static std::vector<StRow> readStats(const std::string& path) {
-    std::ifstream in(path);
-    if (!in) throw std::runtime_error("Cannot open: " + path);
-
     std::vector<StRow> rows;
-    std::string line;
-    std::getline(in, line);
+    if (freshSidecar(path)) {
+        auto d = readColumnar(path + ".col");
+        const auto& step = d.column("step");
+        const auto& processed = d.column("processed");
+        const auto& mean = d.column("mean_est");
+        const auto& stdev = d.column("std_est");
+        rows.reserve(d.rows);
+        for (std::size_t i = 0; i < d.rows; ++i) {
+            rows.push_back({(int)step[i], processed[i], mean[i], stdev[i]});
+        }
+        return rows;
+    }
 
-    while (std::getline(in, line)) {
-        if (trim(line).empty()) continue;
-        auto parts = split(line, ';');
-        if (parts.size() < 4) continue;
+    CsvScanner in(path);
+    in.next();
+
+    while (in.next()) {
+        if (in.blank() || in.size() < 4) continue;
 
         StRow r;
-        r.step      = parseInt(parts[0]);
-        r.processed = parseDouble(parts[1]);
-        r.mean      = parseDouble(parts[2]);
-        r.stdev     = parseDouble(parts[3]);
+        r.step      = in.integer(0);
+        r.processed = in.number(1);
+        r.mean      = in.number(2);
+        r.stdev     = in.number(3);
         rows.push_back(r);
     }
     return rows;
@@ -291,10 +309,14 @@ static void plotGraph2Svg(const std::vector<StRow>& st, const std::string& outPa
         lowerPts.push_back({(double)r.step, std::max(0.0, r.mean - r.stdev)});
     }
 
-    drawBand(out, upperPts, lowerPts, xmin, xmax, ymin, ymax, c, "#240ea4", 5);
+    // полоса и её пунктирные края — из одной огибающей: пики между точками LTTB не пропадают
+    std::vector<std::pair<double,double>> upperEnv, lowerEnv;
+    minMaxEnvelope(upperPts, lowerPts, c.maxPoints, upperEnv, lowerEnv);
+
+    drawBand(out, upperEnv, lowerEnv, xmin, xmax, ymin, ymax, c, "#240ea4", 5);
     drawPolyline(out, meanPts, xmin, xmax, ymin, ymax, c, "#74b6e5", 3);
-    drawPolyline(out, upperPts, xmin, xmax, ymin, ymax, c, "#d62728", 2, "5 3");
-    drawPolyline(out, lowerPts, xmin, xmax, ymin, ymax, c, "#000000", 2, "5 3");
+    drawPoints(out, upperEnv, xmin, xmax, ymin, ymax, c, "#d62728", 2, "5 3");
+    drawPoints(out, lowerEnv, xmin, xmax, ymin, ymax, c, "#000000", 2, "5 3");
 
     drawLegend(out, c, {
         {"E(N_t)", "#74b6e5"},
@@ -306,8 +328,99 @@ static void plotGraph2Svg(const std::vector<StRow>& st, const std::string& outPa
     writeSvgFooter(out);
 }
 
-int main() {
+// Нужные колонки файла: .col как есть, CSV — через спутник или построчно по заголовку.
+static ColumnarData readSeries(const std::string& path, const std::vector<std::string>& names) {
+    const bool col = path.size() > 4 && path.compare(path.size() - 4, 4, ".col") == 0;
+    if (col) return readColumnar(path);
+    if (freshSidecar(path)) return readColumnar(path + ".col");
+
+    CsvScanner in(path);
+    if (!in.next()) throw std::runtime_error("Empty file: " + path);
+    std::vector<std::size_t> idx;
+    for (const auto& name : names) {
+        std::size_t i = 0;
+        while (i < in.size() && in.field(i) != name) ++i;
+        if (i == in.size()) throw std::runtime_error("No column " + name + " in " + path);
+        idx.push_back(i);
+    }
+
+    ColumnarData d;
+    d.names = names;
+    d.columns.resize(names.size());
+    while (in.next()) {
+        if (in.blank()) continue;
+        for (std::size_t k = 0; k < idx.size(); ++k) d.columns[k].push_back(in.number(idx[k]));
+        d.rows++;
+    }
+    return d;
+}
+
+static void plotSeriesSvg(const ColumnarData& d, const std::string& xName,
+                          const std::vector<std::string>& yNames, const std::string& outPath) {
+    static const char* const colors[] = {"#000000", "#1f77b4", "#d62728", "#2ca02c", "#ff7f0e", "#9467bd"};
+    SvgCanvas c{900, 520};
+
+    const auto& xs = d.column(xName);
+    double xmin = xs.front();
+    double xmax = xs.back();
+    double ymin = 0.0;
+    double ymax = 0.0;
+    for (const auto& y : yNames) {
+        for (double v : d.column(y)) ymax = std::max(ymax, v);
+    }
+    ymax *= 1.05;
+
+    std::ofstream out(outPath);
+    writeSvgHeader(out, c.W, c.H);
+
+    std::string yLabel;
+    for (const auto& y : yNames) yLabel += (yLabel.empty() ? "" : ", ") + y;
+    drawAxesAndGrid(out, c, xmin, xmax, ymin, ymax, xName, yLabel, yLabel + " by " + xName);
+
+    std::vector<std::pair<std::string,std::string>> legend;
+    for (std::size_t k = 0; k < yNames.size(); ++k) {
+        const auto& ys = d.column(yNames[k]);
+        std::vector<std::pair<double,double>> pts(d.rows);
+        for (std::size_t i = 0; i < d.rows; ++i) pts[i] = {xs[i], ys[i]};
+        const char* color = colors[k % (sizeof(colors) / sizeof(colors[0]))];
+        drawPolyline(out, pts, xmin, xmax, ymin, ymax, c, color, 2);
+        legend.push_back({yNames[k], color});
+    }
+    drawLegend(out, c, legend);
+
+    writeSvgFooter(out);
+}
+
+int main(int argc, char** argv) {
     try {
+        if (argc > 1) {
+            if (argc < 4) {
+                std::cerr << "usage: plot_svg FILE X Y [Y...] [-o OUT.svg]\n";
+                return 2;
+            }
+            const std::string path = argv[1];
+            const std::string xName = argv[2];
+            std::vector<std::string> yNames;
+            std::string outPath = std::filesystem::path(path).stem().string() + ".svg";
+            for (int i = 3; i < argc; ++i) {
+                std::string a = argv[i];
+                if (a == "-o" && i + 1 < argc) outPath = argv[++i];
+                else yNames.push_back(a);
+            }
+            if (yNames.empty()) throw std::invalid_argument("no Y columns");
+
+            std::vector<std::string> names = yNames;
+            names.insert(names.begin(), xName);
+            auto d = readSeries(path, names);
+            if (d.rows == 0) {
+                std::cerr << "Empty data in " << path << "\n";
+                return 1;
+            }
+            plotSeriesSvg(d, xName, yNames, outPath);
+            std::cout << "Saved: " << outPath << " (" << d.rows << " rows)\n";
+            return 0;
+        }
+
         auto ex = readExample("stage2_example.csv");
         auto st = readStats("stage2_stats.csv");
 
@@ -0,0 +1,116 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+#include "CardinalitySeries.hpp"
+
+// series_run [days=30] [perMinute=500] [B=12] [users=2000000]
+//
+// Синтетический поток посещений с суточным циклом: поминутные HyperLogLog
+// в CardinalitySeries, затем «различных за сутки» и за весь период через дерево
+// отрезков и прямым объединением всех корзин. Проверяет, что объединение всех корзин
+// совпадает по регистрам с одним HyperLogLog по всему потоку, и печатает степень сжатия
+// и число корзин каждой кодировки. При users ~ perMinute (одни и те же пользователи
+// каждую минуту) корзины кодируются разностью с предыдущей, при больших users —
+// разреженно относительно нулей.
+
+static double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    const int days = argc > 1 ? std::atoi(argv[1]) : 30;
+    const std::size_t perMinute = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500;
+    const int B = argc > 3 ? std::atoi(argv[3]) : 12;
+    const std::uint64_t users = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 2000000;
+
+    try {
+        if (days <= 0 || perMinute == 0 || users == 0) throw std::invalid_argument("days, perMinute and users must be positive");
+
+        CardinalitySeries::Options opt;
+        opt.B = B;
+        opt.bucketWidth = 60;
+        CardinalitySeries series(opt);
+        HyperLogLog whole(B);
+
+        HashFuncGen hgen(777);
+        auto h = hgen.make();
+        std::mt19937_64 rng(42);
+        // четверть посещений — небольшое ядро постоянных пользователей
+        std::uniform_int_distribution<std::uint64_t> anyUser(0, users - 1);
+        std::uniform_int_distribution<std::uint64_t> coreUser(0, users / 100);
+        std::bernoulli_distribution fromCore(0.25);
+
+        const std::int64_t t0 = 1700000000 / 86400 * 86400;
+        const std::int64_t minutes = static_cast<std::int64_t>(days) * 1440;
+        auto tb = std::chrono::steady_clock::now();
+        std::size_t events = 0;
+        for (std::int64_t k = 0; k < minutes; ++k) {
+            double phase = 2.0 * M_PI * static_cast<double>(k % 1440) / 1440.0;
+            auto n = static_cast<std::size_t>(perMinute * (1.0 - 0.8 * std::cos(phase)));
+            for (std::size_t i = 0; i < n; ++i) {
+                std::uint64_t u = fromCore(rng) ? coreUser(rng) : anyUser(rng);
+                std::uint32_t x = h("user" + std::to_string(u));
+                series.add(t0 + k * 60 + static_cast<std::int64_t>(i % 60), x);
+                whole.addHash(x);
+            }
+            events += n;
+        }
+        const std::int64_t tEnd = t0 + minutes * 60;
+        series.advanceTo(tEnd);
+        double ingestMs = msSince(tb);
+
+        auto st = series.stats();
+        double rawBytes = static_cast<double>(st.buckets) * (1u << B);
+        std::cout << "Ingested " << events << " events into " << st.buckets << " minute buckets in "
+                  << ingestMs << " ms\n";
+        std::cout << "Storage: " << st.encodedBytes << " bytes encoded vs " << rawBytes << " raw ("
+                  << std::setprecision(3) << rawBytes / std::max<std::size_t>(st.encodedBytes, 1) << std::setprecision(6)
+                  << "x); buckets sparse-delta=" << st.sparseBuckets << " sparse-abs=" << st.sparseAbsBuckets
+                  << " nibble=" << st.nibbleBuckets
+                  << " raw=" << st.rawBuckets << " empty=" << st.emptyBuckets << "\n";
+
+        tb = std::chrono::steady_clock::now();
+        HyperLogLog cold = series.range(t0, tEnd);
+        double coldMs = msSince(tb);
+        std::size_t nodes = series.lastQueryNodes();
+        tb = std::chrono::steady_clock::now();
+        HyperLogLog warm = series.range(t0 + 3600, tEnd - 3600);
+        double warmMs = msSince(tb);
+        std::size_t warmNodes = series.lastQueryNodes();
+        tb = std::chrono::steady_clock::now();
+        HyperLogLog naive = series.rangeNaive(t0 + 3600, tEnd - 3600);
+        double naiveMs = msSince(tb);
+
+        bool same = std::equal(cold.registers(), cold.registers() + cold.m(), whole.registers()) &&
+                    std::equal(warm.registers(), warm.registers() + warm.m(), naive.registers());
+        std::cout << "Full range: estimate=" << std::setprecision(10) << cold.estimate() << std::setprecision(6)
+                  << ", " << nodes << " nodes, cold " << coldMs << " ms\n";
+        std::cout << "Range minus 1h at both ends: " << warmNodes << " nodes, " << warmMs << " ms (tree, warm) vs "
+                  << naiveMs << " ms (" << (minutes - 120) << " buckets merged directly)\n";
+
+        std::cout << "Distinct per day:";
+        for (double v : series.rollup(t0, tEnd, 86400)) std::cout << " " << std::llround(v);
+        std::cout << "\nDistinct per hour, day 1:";
+        for (double v : series.rollup(t0, t0 + 86400, 3600)) std::cout << " " << std::llround(v);
+        st = series.stats();
+        std::cout << "\nCache: " << st.cachedNodes << " nodes, " << st.cacheBytes << " bytes, hits=" << st.cacheHits
+                  << ", misses=" << st.cacheMisses << "\n";
+
+        if (!same) {
+            std::cerr << "Error: merged buckets differ from the single-sketch registers\n";
+            return 1;
+        }
+        std::cout << "Registers of merged buckets match a single HyperLogLog over the stream\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
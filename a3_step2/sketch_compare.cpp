@@ -0,0 +1,144 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <functional>
+
+#include "RandomStreamGen.hpp"
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+#include "HyperLogLog4.hpp"
+#include "LinearCounting.hpp"
+#include "KmvSketch.hpp"
+#include "Experiment.hpp"
+#include "ReportWriter.hpp"
+
+struct SketchReport {
+    std::string name;
+    std::size_t bytes = 0;
+    double nsPerInsert = 0.0;
+    std::vector<double> meanRelErr; // по шагам
+    std::vector<double> stdRelErr;
+};
+
+template <class Sketch>
+static double insertNs(Sketch& sketch, const std::vector<std::uint32_t>& hashes, int repeats) {
+    double best = 1e300;
+    for (int r = 0; r < repeats; ++r) {
+        sketch.reset();
+        auto t0 = std::chrono::steady_clock::now();
+        for (std::uint32_t x : hashes) sketch.addHash(x);
+        auto t1 = std::chrono::steady_clock::now();
+        volatile double sink = sketch.estimate();
+        (void)sink;
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        best = std::min(best, ns / hashes.size());
+    }
+    return best;
+}
+
+template <class Sketch>
+static SketchReport runSketch(Sketch& sketch,
+                              const std::vector<std::vector<std::string>>& streams,
+                              const std::vector<HashFunc>& hashes,
+                              const std::vector<std::size_t>& steps) {
+    SketchReport rep;
+    rep.name = sketch.name();
+    rep.bytes = sketch.memoryBytes();
+
+    std::vector<std::vector<double>> relErr(steps.size());
+    for (std::size_t i = 0; i < streams.size(); ++i) {
+        auto res = processOneStream(streams[i], hashes[i], sketch, steps);
+        for (std::size_t t = 0; t < res.size(); ++t) {
+            double f0 = static_cast<double>(res[t].F0);
+            relErr[t].push_back((res[t].Nt - f0) / f0);
+        }
+    }
+    for (const auto& v : relErr) {
+        rep.meanRelErr.push_back(mean(v));
+        rep.stdRelErr.push_back(sampleStd(v));
+    }
+
+    std::vector<std::uint32_t> hashed;
+    hashed.reserve(streams[0].size());
+    for (const auto& s : streams[0]) hashed.push_back(hashes[0](s));
+    rep.nsPerInsert = insertNs(sketch, hashed, 5);
+    rep.bytes = std::max(rep.bytes, sketch.memoryBytes());
+    return rep;
+}
+
+int main() {
+    const std::size_t N = 200000;
+    const std::size_t K = 20;
+    const std::size_t stepPercent = 10;
+    const int B = 14;
+
+    const std::uint64_t baseStreamSeed = 42;
+    const std::uint64_t baseHashSeed = 777;
+
+    auto steps = RandomStreamGen::prefixSizesByPercent(N, stepPercent);
+
+    std::vector<std::vector<std::string>> streams;
+    std::vector<HashFunc> hashes;
+    for (std::size_t i = 0; i < K; ++i) {
+        RandomStreamGen::Config cfg;
+        cfg.seed = baseStreamSeed + i;
+        RandomStreamGen gen(cfg);
+        streams.push_back(gen.generate(N));
+
+        HashFuncGen hgen(baseHashSeed + i);
+        hashes.push_back(hgen.make());
+    }
+
+    std::vector<SketchReport> reports;
+    {
+        HyperLogLog s(B);
+        reports.push_back(runSketch(s, streams, hashes, steps));
+    }
+    {
+        HyperLogLog4 s(B);
+        reports.push_back(runSketch(s, streams, hashes, steps));
+    }
+    {
+        LinearCounting s(B + 4);
+        reports.push_back(runSketch(s, streams, hashes, steps));
+    }
+    {
+        KmvSketch s(1u << 12);
+        reports.push_back(runSketch(s, streams, hashes, steps));
+    }
+
+    std::cout << "sketch; bytes; ns/insert; mean rel.err (last step); std rel.err (last step)\n";
+    for (const auto& r : reports) {
+        std::cout << r.name << "; "
+                  << r.bytes << "; "
+                  << r.nsPerInsert << "; "
+                  << r.meanRelErr.back() << "; "
+                  << r.stdRelErr.back() << "\n";
+    }
+
+    {
+        ReportWriter out("sketch_compare.csv",
+                         {"sketch", "bytes", "ns_per_insert", "step", "processed", "mean_rel_err", "std_rel_err"},
+                         true);
+        for (const auto& r : reports) {
+            for (std::size_t t = 0; t < steps.size(); ++t) {
+                out.field(r.name)
+                   .field(r.bytes)
+                   .field(r.nsPerInsert, 3)
+                   .field(t + 1)
+                   .field(steps[t])
+                   .field(r.meanRelErr[t], 6)
+                   .field(r.stdRelErr[t], 6);
+                out.endRow();
+            }
+        }
+    }
+
+    std::cout << "Saved: sketch_compare.csv\n";
+    std::cout << "Params: N=" << N << ", K=" << K
+              << ", step=" << stepPercent << "%, B=" << B << "\n";
+    return 0;
+}
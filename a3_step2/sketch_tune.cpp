@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "RandomStreamGen.hpp"
+#include "HashFuncGen.hpp"
+#include "SketchConfig.hpp"
+#include "SketchFleet.hpp"
+
+// Подбор B и хранения регистров по бюджету памяти:
+//
+//   sketch_tune ERR BUDGET_BYTES [expected=0] [keys=1]
+//       ERR — целевая относительная ошибка (0.01 = 1%), BUDGET — на скетч, а при keys > 1
+//       на весь набор ключей; expected — ожидаемое число уникальных на скетч (0 — неизвестно)
+//
+//       При keys > 1 набор SketchFleet с выбранным хранением заполняется expected
+//       уникальными на ключ, и его память сверяется с бюджетом.
+//
+//   sketch_tune --fleet KEYS N RSS_LIMIT_MB [B=16] [byte|packed4|sparse]
+//       набор скетчей по KEYS ключам под потолком RSS: по мере роста скетчи
+//       сворачиваются, в конце свёрнутые регистры сверяются с построенными сразу при
+//       итоговом B (для packed4 — только без обрезки регистров, поэтому не сверяется)
+
+static void printConfig(const SketchConfig& c) {
+    std::cout << "B=" << c.B << " (m=" << (1u << c.B) << ")"
+              << ", encoding=" << encodingName(c.encoding)
+              << ", hash=" << c.hashBits << " bit"
+              << ", bytes<=" << c.bytes << " (+" << c.overheadBytes << " object)"
+              << ", expected error=" << c.expectedError * 100.0 << "%"
+              << (c.meetsTarget ? "" : "  (budget too small for the target error)") << "\n";
+}
+
+static RegisterEncoding parseEncoding(const std::string& s) {
+    for (RegisterEncoding e : {RegisterEncoding::Byte, RegisterEncoding::Packed4, RegisterEncoding::Sparse}) {
+        if (s == encodingName(e)) return e;
+    }
+    throw std::invalid_argument("unknown encoding: " + s);
+}
+
+static int fleetDemo(std::size_t keys, std::size_t N, std::size_t rssLimit, int B, RegisterEncoding enc) {
+    RandomStreamGen::Config cfg;
+    cfg.seed = 42;
+    RandomStreamGen gen(cfg);
+    auto stream = gen.generate(N);
+    HashFuncGen hgen(777);
+    auto h = hgen.make();
+
+    auto keyOf = [&](std::size_t i) { return "key" + std::to_string(i % keys); };
+
+    SketchFleet fleet(B, 4, enc);
+    const std::size_t checkEvery = 10000;
+    for (std::size_t i = 0; i < stream.size(); ++i) {
+        fleet.add(keyOf(i), h(stream[i]));
+        if ((i + 1) % checkEvery == 0 && fleet.enforceRss(rssLimit)) {
+            std::cout << "after " << (i + 1) << " elements: folded to B=" << fleet.B()
+                      << ", sketches " << fleet.sketchBytes() << " bytes, RSS "
+                      << SketchFleet::currentRssBytes() / 1024 << " KiB\n";
+        }
+    }
+
+    // Свёртка должна давать ровно те же регистры, что и построение с итоговым B.
+    std::size_t checked = 0;
+    for (std::size_t k = 0; enc != RegisterEncoding::Packed4 && k < std::min<std::size_t>(keys, 8); ++k) {
+        HyperLogLog direct(fleet.B());
+        for (std::size_t i = k; i < stream.size(); i += keys) direct.addHash(h(stream[i]));
+        if (!fleet.find(keyOf(k))) continue;
+        HyperLogLog f = fleet.registers(keyOf(k));
+        if (!std::equal(direct.registers(), direct.registers() + direct.m(), f.registers())) {
+            std::cerr << "Error: folded registers differ for " << keyOf(k) << "\n";
+            return 1;
+        }
+        checked++;
+    }
+
+    std::cout << keys << " " << encodingName(enc) << " sketches, final B=" << fleet.B() << ", folds=" << fleet.folds()
+              << ", sketches " << fleet.sketchBytes() << " bytes, RSS "
+              << SketchFleet::currentRssBytes() / 1024 << " KiB"
+              << ", key0 estimate=" << fleet.estimate(keyOf(0))
+              << "; folded == direct for " << checked << " keys\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    try {
+        if (argc >= 5 && std::string(argv[1]) == "--fleet") {
+            std::size_t keys = std::strtoull(argv[2], nullptr, 10);
+            std::size_t N = std::strtoull(argv[3], nullptr, 10);
+            std::size_t rss = std::strtoull(argv[4], nullptr, 10) << 20;
+            int B = argc > 5 ? std::atoi(argv[5]) : 16;
+            RegisterEncoding enc = argc > 6 ? parseEncoding(argv[6]) : RegisterEncoding::Byte;
+            if (keys == 0) throw std::invalid_argument("KEYS must be positive");
+            return fleetDemo(keys, N, rss, B, enc);
+        }
+        if (argc < 3) {
+            std::cerr << "usage: sketch_tune ERR BUDGET_BYTES [expected] [keys]\n"
+                         "       sketch_tune --fleet KEYS N RSS_LIMIT_MB [B] [byte|packed4|sparse]\n";
+            return 2;
+        }
+
+        SketchRequirements req;
+        req.targetError = std::atof(argv[1]);
+        std::size_t budget = std::strtoull(argv[2], nullptr, 10);
+        req.expectedCardinality = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 0;
+        std::size_t keys = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 1;
+
+        SketchConfig c;
+        if (keys > 1) {
+            c = tuneFleet(budget, keys, req);
+        } else {
+            req.budgetBytes = budget;
+            c = tuneSketch(req);
+        }
+        printConfig(c);
+
+        // сверка модели с фактическим memoryBytes() после expected уникальных
+        auto sketch = makeSketch(c);
+        std::uint64_t x = 0x9e3779b97f4a7c15ULL;
+        std::size_t peak = sketch->memoryBytes();
+        for (std::uint64_t i = 0; i < req.expectedCardinality; ++i) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            sketch->addHash(static_cast<std::uint32_t>(x >> 32));
+            peak = std::max(peak, sketch->memoryBytes());
+        }
+        std::cout << "Measured memoryBytes(): peak " << peak << " over " << req.expectedCardinality
+                  << " distinct (" << (peak <= c.bytes ? "within" : "EXCEEDS") << " the model)\n";
+        if (peak > c.bytes) return 1;
+
+        if (keys > 1) {
+            // тот же выбор, применённый к набору: регистры и объекты всех ключей против бюджета
+            SketchFleet fleet(c);
+            std::size_t fleetPeak = 0;
+            for (std::size_t k = 0; k < keys; ++k) {
+                const std::string key = "key" + std::to_string(k);
+                for (std::uint64_t i = 0; i < req.expectedCardinality; ++i) {
+                    x ^= x << 13;
+                    x ^= x >> 7;
+                    x ^= x << 17;
+                    fleet.add(key, static_cast<std::uint32_t>(x >> 32));
+                    fleetPeak = std::max(fleetPeak, fleet.sketchBytes());
+                }
+            }
+            std::size_t charged = fleetPeak + keys * c.overheadBytes;
+            std::cout << "SketchFleet(" << encodingName(fleet.encoding()) << ", B=" << fleet.B() << "): "
+                      << fleetPeak << " bytes of registers + " << keys * c.overheadBytes << " object = "
+                      << charged << " of " << budget << " budget\n";
+            if (charged > budget) return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
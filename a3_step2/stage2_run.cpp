@@ -2,94 +2,15 @@
 #include <vector>
 #include <string>
 #include <unordered_set>
-#include <fstream>
 #include <cmath>
 #include <algorithm>
-#include <iomanip>
-#include <sstream>
-
-#include "RandomStreamGen.cpp"
-#include "HashFuncGen.cpp"
-#include "HyperLogLog.cpp"
-
-struct StepResult {
-    std::size_t processed = 0;
-    std::size_t F0 = 0;
-    double Nt = 0.0;
-};
-
-static std::string excelDouble(double x, int precision = 6) {
-    std::ostringstream oss;
-    oss.imbue(std::locale::classic());
-    oss << std::fixed << std::setprecision(precision) << x;
-
-    std::string s = oss.str();
-    for (char& c : s) {
-        if (c == '.') c = ',';
-    }
-
-    while (s.size() > 1 && s.back() == '0') s.pop_back();
-    if (!s.empty() && s.back() == ',') s.pop_back();
-
-    return s;
-}
-
-static double mean(const std::vector<double>& a) {
-    double s = 0.0;
-    for (double x : a) s += x;
-    return s / a.size();
-}
-
-static double sampleStd(const std::vector<double>& a) {
-    if (a.size() < 2) return 0.0;
-    double m = mean(a);
-    double ss = 0.0;
-    for (double x : a) {
-        double d = x - m;
-        ss += d * d;
-    }
-    return std::sqrt(ss / (a.size() - 1));
-}
-
-static std::vector<StepResult> processOneStream(
-    const std::vector<std::string>& stream,
-    const HashFunc& h,
-    int B,
-    const std::vector<std::size_t>& steps
-) {
-    std::unordered_set<std::string> uniq;
-    uniq.reserve(stream.size());
-
-    HyperLogLog hll(B);
-
-    std::vector<StepResult> out;
-    out.reserve(steps.size());
-
-    std::size_t stepIdx = 0;
-    std::size_t nextStop = steps[stepIdx];
-
-    for (std::size_t i = 0; i < stream.size(); ++i) {
-        const auto& s = stream[i];
-
-        uniq.insert(s);
-
-        hll.addHash(h(s));
 
-        std::size_t processed = i + 1;
-        if (processed == nextStop) {
-            StepResult r;
-            r.processed = processed;
-            r.F0 = uniq.size();
-            r.Nt = hll.estimate();
-            out.push_back(r);
-
-            stepIdx++;
-            if (stepIdx >= steps.size()) break;
-            nextStop = steps[stepIdx];
-        }
-    }
-    return out;
-}
+#include "RandomStreamGen.hpp"
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+#include "Experiment.hpp"
+#include "ReportWriter.hpp"
+#include "Instrumentation.hpp"
 
 int main() {
     const std::size_t N = 200000;
@@ -105,6 +26,11 @@ int main() {
     std::vector<std::vector<double>> Nt_values(steps.size());
     for (auto& v : Nt_values) v.reserve(K);
 
+    // Погрешность из самого скетча (estimateWithError) против разброса по K потокам.
+    std::vector<double> theoryStd(steps.size(), 0.0);
+    std::vector<double> groupStd(steps.size(), 0.0);
+    std::vector<std::size_t> covered(steps.size(), 0);
+
     std::vector<StepResult> example;
 
     for (std::size_t i = 0; i < K; ++i) {
@@ -116,45 +42,65 @@ int main() {
         HashFuncGen hgen(baseHashSeed + i);
         auto h = hgen.make();
 
-        auto res = processOneStream(stream, h, B, steps);
+        HyperLogLog hll(B);
+        auto res = processOneStream(stream, h, hll, steps);
 
         if (i == 0) example = res;
 
         for (std::size_t t = 0; t < res.size(); ++t) {
             Nt_values[t].push_back(res[t].Nt);
+            theoryStd[t] += res[t].stdErr / K;
+            groupStd[t] += res[t].groupStdErr / K;
+            covered[t] += res[t].lower <= res[t].F0 && res[t].F0 <= res[t].upper;
         }
 
         std::cout << "Processed stream " << (i + 1) << "/" << K << "\n";
     }
 
     {
-        std::ofstream out("stage2_example.csv");
-        out << "step;processed;F0_true;N_est\n";
+        ReportWriter out("stage2_example.csv", {"step", "processed", "F0_true", "N_est"}, true);
         for (std::size_t t = 0; t < example.size(); ++t) {
-            out << (t + 1) << ";"
-                << example[t].processed << ";"
-                << example[t].F0 << ";"
-                << excelDouble(example[t].Nt, 3) << "\n";
+            out.field(t + 1)
+               .field(example[t].processed)
+               .field(example[t].F0)
+               .field(example[t].Nt, 3);
+            out.endRow();
         }
     }
 
     {
-        std::ofstream out("stage2_stats.csv");
-        out << "step;processed;mean_est;std_est\n";
+        ReportWriter out("stage2_stats.csv", {"step", "processed", "mean_est", "std_est"}, true);
         for (std::size_t t = 0; t < steps.size(); ++t) {
             double m = mean(Nt_values[t]);
             double s = sampleStd(Nt_values[t]);
-            out << (t + 1) << ";"
-                << steps[t] << ";"
-                << excelDouble(m, 3) << ";"
-                << excelDouble(s, 3) << "\n";
+            out.field(t + 1)
+               .field(steps[t])
+               .field(m, 3)
+               .field(s, 3);
+            out.endRow();
+        }
+    }
+
+    {
+        ReportWriter out("stage2_error.csv",
+                         {"step", "processed", "std_trials", "std_theory", "std_groups", "ci95_coverage"}, true);
+        for (std::size_t t = 0; t < steps.size(); ++t) {
+            out.field(t + 1)
+               .field(steps[t])
+               .field(sampleStd(Nt_values[t]), 3)
+               .field(theoryStd[t], 3)
+               .field(groupStd[t], 3)
+               .field(static_cast<double>(covered[t]) / K, 3);
+            out.endRow();
         }
     }
 
-    std::cout << "Saved: stage2_example.csv, stage2_stats.csv\n";
+    std::cout << "Saved: stage2_example.csv, stage2_stats.csv, stage2_error.csv (+ .col)\n";
     std::cout << "Params: N=" << N << ", K=" << K
               << ", step=" << stepPercent << "%, B=" << B
               << ", m=" << (1u << B) << "\n";
 
+    instr::printBreakdown(std::cout, instr::snapshot());
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "RandomStreamGen.hpp"
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+#include "HeavyHitters.hpp"
+
+// topk_run [k=256] [N=2000000] [show=10] [file]
+//
+// Число уникальных и самые частые ключи за один проход (HyperLogLog + SpaceSaving
+// на общем хеше). Без файла поток берётся из словаря RandomStreamGen с частотой
+// ранга r ~ 1/r (ранг = floor(V^u), u равномерно на [0, 1)), чтобы было что искать.
+// Для сравнения — те же структуры двумя отдельными проходами и точный подсчёт.
+
+static std::vector<std::string> skewedStream(std::size_t N) {
+    RandomStreamGen::Config cfg;
+    cfg.seed = 42;
+    cfg.minLen = 8;
+    cfg.maxLen = 16;
+    RandomStreamGen gen(cfg);
+    const std::size_t V = std::max<std::size_t>(N / 10, 1);
+    auto vocab = gen.generate(V);
+
+    std::mt19937_64 rng(43);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::vector<std::string> stream;
+    stream.reserve(N);
+    for (std::size_t i = 0; i < N; ++i) {
+        std::size_t r = static_cast<std::size_t>(std::pow(static_cast<double>(V), u(rng)));
+        stream.push_back(vocab[std::min(r, V) - 1]);
+    }
+    return stream;
+}
+
+template <class F>
+static double seconds(F&& f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    const std::size_t k = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256;
+    const std::size_t N = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+    const std::size_t show = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 10;
+    const int B = 14;
+
+    try {
+        auto stream = argc > 4 ? RandomStreamGen::loadFromFile(argv[4]) : skewedStream(N);
+        HashFuncGen hgen(777);
+        auto h = hgen.make();
+
+        HyperLogLog hll(B);
+        SpaceSaving top(k);
+        double combined = seconds([&] {
+            DistinctTopK<HyperLogLog> stage(h, hll, top);
+            stage.addBatch(stream.data(), stream.size());
+        });
+
+        HyperLogLog hll2(B);
+        SpaceSaving top2(k);
+        double separate = seconds([&] {
+            for (const auto& s : stream) hll2.addHash(h(s));
+            for (const auto& s : stream) top2.add(s, h(s));
+        });
+
+        std::unordered_map<std::string, std::uint64_t> exact;
+        double exactSec = seconds([&] {
+            exact.reserve(stream.size());
+            for (const auto& s : stream) exact[s]++;
+        });
+
+        std::cout << "Elements: " << stream.size() << ", distinct: exact=" << exact.size()
+                  << ", HLL(B=" << B << ")=" << std::llround(hll.estimate()) << "\n";
+        std::cout << "Top " << std::min(show, k) << " of SpaceSaving(k=" << k << "):\n";
+        for (const auto& it : top.top(show)) {
+            std::cout << "  " << it.key << "  count=" << it.count << " (+-" << it.error << ")"
+                      << "  exact=" << exact[it.key] << "\n";
+        }
+
+        const double n = static_cast<double>(stream.size());
+        std::cout << "Time: one pass " << combined * 1e9 / n << " ns/elem, two passes "
+                  << separate * 1e9 / n << " ns/elem, exact unordered_map " << exactSec * 1e9 / n
+                  << " ns/elem\n";
+        std::cout << "Memory: HLL " << hll.memoryBytes() << " bytes, SpaceSaving ~" << top.memoryBytes()
+                  << " bytes\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
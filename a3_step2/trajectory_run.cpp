@@ -0,0 +1,58 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "RandomStreamGen.hpp"
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+#include "Experiment.hpp"
+#include "ReportWriter.hpp"
+
+// trajectory_run [stride=1] [N=200000] [B=14] [out=trajectory.col]
+//
+// Оценка HyperLogLog и точное F0 после каждых stride элементов — для изучения
+// перехода linear counting -> сырая оценка (граница 2.5 * m) с любой детализацией.
+// Пишет колоночный файл (см. ReportWriter.hpp) по мере счёта: processed, F0_true (u64), N_est (f64).
+// Относительная ошибка не хранится: это (N_est - F0_true) / F0_true.
+// График: plot_svg trajectory.col processed F0_true N_est
+
+int main(int argc, char** argv) {
+    const std::size_t stride = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1;
+    const std::size_t N = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+    const int B = argc > 3 ? std::atoi(argv[3]) : 14;
+    const std::string outPath = argc > 4 ? argv[4] : "trajectory.col";
+
+    try {
+        if (stride == 0 || N == 0) throw std::invalid_argument("stride and N must be positive");
+
+        RandomStreamGen::Config cfg;
+        cfg.seed = 42;
+        RandomStreamGen gen(cfg);
+        auto stream = gen.generate(N);
+
+        HashFuncGen hgen(777);
+        auto h = hgen.make();
+        HyperLogLog hll(B);
+
+        ColumnarWriter out(outPath, {"processed", "F0_true", "N_est"});
+        auto t0 = std::chrono::steady_clock::now();
+        processTrajectory(stream, h, hll, stride, [&](const StepResult& r) {
+            out.integer(0, r.processed);
+            out.integer(1, r.F0);
+            out.number(2, r.Nt);
+            out.endRow();
+        });
+        out.close();
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        std::cout << "Saved: " << outPath << " (" << out.rows() << " points)\n";
+        std::cout << "Params: N=" << N << ", stride=" << stride << ", B=" << B
+                  << ", m=" << (1u << B) << "\n";
+        std::cout << "Time: " << sec << " s, " << (sec * 1e9 / N) << " ns per element\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}